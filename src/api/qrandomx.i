@@ -54,6 +54,7 @@ namespace std {
         %template(ucharVector) vector<unsigned char>;
         %template(charVector) vector<char>;
         %template(doubleVector) vector<double>;
+        %template(uint64Vector) vector<uint64_t>;
 
         %template(_string_list) vector<string>;
         %template(_string_list_list) vector<vector<unsigned char>>;
@@ -87,21 +88,137 @@ Swig::DirectorMethodException::raise(err_msg.c_str());
 }
 
 #if defined(SWIGPYTHON)
-%module(directors="1") pyqrandomx
+%module(directors="1", threads="1") pyqrandomx
 #else
 %module(directors="1") goqrandomx
 #endif
 %{
 #include "pow/powhelper.h"
+#include "pow/difficultysim.h"
 #include "misc/strbignum.h"
+#include "misc/metrics.h"
+#include "misc/tracing.h"
 #include "qrandomx/threadedqrandomx.h"
 #include "qrandomx/qrxminer.h"
+#include "qrandomx/largepages.h"
+#include "qrandomx/randomxflags.h"
 %}
 
 %feature("director") QRXMiner;
 
+// GIL policy. Calls that can block - hashing (which may initialize a cache or the dataset),
+// waiting for the proxy, mining or event threads, joining threads in cancel() and the
+// destructors - release the GIL so other Python threads keep running meanwhile. Everything
+// else is short and keeps it: releasing lets a waiting thread take the GIL, and getting it
+// back can cost a whole switch interval. Callbacks into Python (QRXMiner::handleEvent) take
+// the GIL themselves, and no native lock is held while they run, so releasing cannot deadlock.
+// Add new blocking entry points here.
+%feature("nothreadallow");
+%feature("nothreadallow", "0") ThreadedQRandomX::~ThreadedQRandomX;
+%feature("nothreadallow", "0") ThreadedQRandomX::getSeedHeight;
+%feature("nothreadallow", "0") ThreadedQRandomX::hash;
+%feature("nothreadallow", "0") ThreadedQRandomX::hashInto;
+%feature("nothreadallow", "0") ThreadedQRandomX::freeVM;
+%feature("nothreadallow", "0") QRXMiner::~QRXMiner;
+%feature("nothreadallow", "0") QRXMiner::start;
+%feature("nothreadallow", "0") QRXMiner::cancel;
+%feature("nothreadallow", "0") QRXMiner::waitForAnswer;
+%feature("nothreadallow", "0") QRXMiner::waitForEvent;
+%feature("nothreadallow", "0") PoWHelper::verifyInput;
+%feature("nothreadallow", "0") PoWHelper::verifyInputs;
+%feature("nothreadallow", "0") PoWHelper::passesTargets;
+%feature("nothreadallow", "0") PoWHelper::passesDifficulties;
+%feature("nothreadallow", "0") PoWHelper::scanTarget;
+%feature("nothreadallow", "0") PoWHelper::getTargets;
+%feature("nothreadallow", "0") PoWHelper::hashBatch;
+%feature("nothreadallow", "0") DifficultySimulator::simulate;
+%feature("nothreadallow", "0") DifficultySimulator::replay;
+%feature("nothreadallow", "0") LargePages::preallocate;
+
+#if defined(SWIGPYTHON)
+// Pass any object supporting the buffer protocol (bytes, bytearray, memoryview,
+// numpy arrays...) as a pointer + length without copying it
+%define %buffer_readonly(PTR, LEN)
+%typemap(in) (PTR, LEN) (Py_buffer view) {
+  view.obj = NULL;
+  if (PyObject_GetBuffer($input, &view, PyBUF_SIMPLE) != 0) {
+    SWIG_fail;
+  }
+  $1 = ($1_ltype) view.buf;
+  $2 = ($2_ltype) view.len;
+}
+%typemap(freearg) (PTR, LEN) {
+  if (view$argnum.obj != NULL) {
+    PyBuffer_Release(&view$argnum);
+  }
+}
+%enddef
+
+%define %buffer_writable(PTR, LEN)
+%typemap(in) (PTR, LEN) (Py_buffer view) {
+  view.obj = NULL;
+  if (PyObject_GetBuffer($input, &view, PyBUF_WRITABLE) != 0) {
+    SWIG_fail;
+  }
+  $1 = ($1_ltype) view.buf;
+  $2 = ($2_ltype) view.len;
+}
+%typemap(freearg) (PTR, LEN) {
+  if (view$argnum.obj != NULL) {
+    PyBuffer_Release(&view$argnum);
+  }
+}
+%enddef
+
+%buffer_readonly(const uint8_t *hashes, size_t hashes_len)
+%buffer_readonly(const uint8_t *targets, size_t targets_len)
+%buffer_readonly(const uint8_t *target, size_t target_len)
+%buffer_readonly(const uint8_t *difficulties, size_t difficulties_len)
+%buffer_writable(uint8_t *targets, size_t targets_len)
+%buffer_writable(uint8_t *bitmap, size_t bitmap_len)
+%buffer_readonly(const uint8_t *seedHash, size_t seedHash_len)
+%buffer_readonly(const uint8_t *input, size_t input_len)
+%buffer_writable(uint8_t *output, size_t output_len)
+%buffer_readonly(const uint8_t *inputs, size_t inputs_len)
+%buffer_writable(uint8_t *outputs, size_t outputs_len)
+#endif
+
 %include "pow/powhelper.h"
+%template(PoWVerifyItemVector) std::vector<PoWVerifyItem>;
+%include "pow/difficultysim.h"
+%template(DifficultySimParamsVector) std::vector<DifficultySimParams>;
+%template(DifficultySimStatsVector) std::vector<DifficultySimStats>;
 %include "misc/strbignum.h"
+%include "misc/metrics.h"
+%include "misc/tracing.h"
 %include "qrandomx/threadedqrandomx.h"
 %include "qrandomx/qrxminer.h"
+%template(MinerEventVector) std::vector<MinerEvent>;
+%include "qrandomx/largepages.h"
+%include "qrandomx/randomxflags.h"
 
+#if defined(SWIGPYTHON)
+%pythoncode %{
+def hash_batch(main_height, seed_height, seed_hash, inputs, thread_count=0):
+    """
+    Hashes a batch of equally sized blobs with one seed on native threads (thread_count=0: one
+    per core). inputs is a list of bytes-like blobs, returning N*32 bytes, or a C-contiguous
+    2-D uint8 numpy array, returning an (N, 32) uint8 array.
+    """
+    if getattr(inputs, 'ndim', None) == 2:
+        import numpy
+        outputs = numpy.empty((inputs.shape[0], 32), dtype=numpy.uint8)
+        PoWHelper.hashBatch(main_height, seed_height, seed_hash, inputs, inputs.shape[1], outputs, thread_count)
+        return outputs
+
+    inputs = [memoryview(blob).cast('B') for blob in inputs]
+    if not inputs:
+        return b''
+    input_size = len(inputs[0])
+    if any(len(blob) != input_size for blob in inputs):
+        raise ValueError("all inputs must have the same length")
+    outputs = bytearray(32 * len(inputs))
+    PoWHelper.hashBatch(main_height, seed_height, seed_hash, b''.join(inputs), input_size, outputs, thread_count)
+    return bytes(outputs)
+%}
+#endif
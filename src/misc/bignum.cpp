@@ -3,58 +3,127 @@
 
 #include "bignum.h"
 
-uint256_t fromByteVector(const std::vector<uint8_t> &vec)
+namespace {
+  const char hexDigits[] = "0123456789abcdef";
+
+  int8_t hexValue(char c)
+  {
+    static const std::array<int8_t, 256> table = []() {
+      std::array<int8_t, 256> t{};
+      t.fill(-1);
+      for (int i = 0; i<10; i++)
+      {
+        t['0'+i] = static_cast<int8_t>(i);
+      }
+      for (int i = 0; i<6; i++)
+      {
+        t['a'+i] = static_cast<int8_t>(10+i);
+        t['A'+i] = static_cast<int8_t>(10+i);
+      }
+      return t;
+    }();
+    return table[static_cast<uint8_t>(c)];
+  }
+}
+
+uint256_t fromBytes(const uint8_t *data, size_t len)
 {
-  if (vec.size()!=32)
+  if (len!=32)
   {
     throw std::invalid_argument("vector size should be 32");
   }
 
   uint256_t tmp(0);
-  for(uint8_t i=0; i<32; i++)
+  boost::multiprecision::import_bits(tmp, data, data+32);
+  return tmp;
+}
+
+void toBytes(const uint256_t &val, uint8_t *out)
+{
+  // read the limbs directly, shifting a copy byte by byte is far slower
+  using limb_type = boost::multiprecision::limb_type;
+  const limb_type *limbs = val.backend().limbs();
+  const size_t size = val.backend().size();
+
+  std::fill(out, out+32, 0);
+  for (size_t i = 0; i<size && i*sizeof(limb_type)<32; i++)
   {
-    tmp<<=8;
-    tmp+=vec.at(i);
+    for (size_t b = 0; b<sizeof(limb_type) && i*sizeof(limb_type)+b<32; b++)
+    {
+      out[31-(i*sizeof(limb_type)+b)] = static_cast<uint8_t>(limbs[i] >> (8*b));
+    }
   }
+}
+
+uint256_t fromByteArray(const std::array<uint8_t, 32> &arr)
+{
+  return fromBytes(arr.data(), arr.size());
+}
+
+std::array<uint8_t, 32> toByteArray(const uint256_t &val)
+{
+  std::array<uint8_t, 32> tmp;
+  toBytes(val, tmp.data());
   return tmp;
 }
 
-std::vector<uint8_t> toByteVector(uint256_t val)
+uint256_t fromByteVector(const std::vector<uint8_t> &vec)
+{
+  return fromBytes(vec.data(), vec.size());
+}
+
+std::vector<uint8_t> toByteVector(const uint256_t &val)
 {
-  std::vector<uint8_t> tmp(32, 0);
+  std::vector<uint8_t> tmp(32);
+  toBytes(val, tmp.data());
+  return tmp;
+}
 
-  for(uint8_t i=0; i<32; i++)
+void hexEncode(const uint8_t *data, size_t len, char *out)
+{
+  for (size_t i = 0; i<len; i++)
   {
-    tmp[31-i] = uint8_t(val & 0xFF);
-    val>>=8;
+    out[2*i] = hexDigits[data[i] >> 4];
+    out[2*i+1] = hexDigits[data[i] & 0x0F];
   }
+}
 
-  return tmp;
+void hexDecode(const char *hex, size_t len, uint8_t *out)
+{
+  for (size_t i = 0; i<len; i++)
+  {
+    const int8_t hi = hexValue(hex[2*i]);
+    const int8_t lo = hexValue(hex[2*i+1]);
+    if (hi<0 || lo<0)
+    {
+      throw std::invalid_argument("invalid hex character");
+    }
+    out[i] = static_cast<uint8_t>((hi << 4) | lo);
+  }
 }
 
 std::string printByteVector(const std::vector<uint8_t> &vec)
 {
-  std::stringstream ss;
+  std::string s;
+  s.reserve(vec.size()*6+vec.size()/8);
 
-  for(int i=0; i<vec.size(); i++)
+  for(size_t i=0; i<vec.size(); i++)
   {
     if (i>0 && i%8==0)
-      ss << std::endl;
-    ss << "0x" << std::setfill('0') << std::setw(2) << std::hex << (int)(vec[i]);
+      s += '\n';
+    s += "0x";
+    s += hexDigits[vec[i] >> 4];
+    s += hexDigits[vec[i] & 0x0F];
     if (i<vec.size()-1)
-      ss << ", ";
+      s += ", ";
   }
 
-  return ss.str();
+  return s;
 }
 
 std::string printByteVector2(const std::vector<uint8_t> &vec)
 {
-  std::stringstream ss;
-
-  for (unsigned char i : vec) {
-    ss << std::setfill('0') << std::setw(2) << std::hex << (int) i;
-  }
-
-  return ss.str();
+  std::string s(vec.size()*2, '0');
+  hexEncode(vec.data(), vec.size(), &s[0]);
+  return s;
 }
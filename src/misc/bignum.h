@@ -4,6 +4,7 @@
 #ifndef QRANDOMX_BIGNUM_H
 #define QRANDOMX_BIGNUM_H
 
+#include <array>
 #include <vector>
 #include <cstdint>
 #include <boost/multiprecision/cpp_int.hpp>
@@ -12,8 +13,19 @@ using uint256_t =  boost::multiprecision::uint256_t;
 using bigint = boost::multiprecision::number<boost::multiprecision::cpp_int_backend<>>;
 
 uint256_t fromByteVector(const std::vector<uint8_t> &vec);
-std::vector<uint8_t> toByteVector(uint256_t);
+std::vector<uint8_t> toByteVector(const uint256_t &val);
 std::string printByteVector(const std::vector<uint8_t> &vec);
 std::string printByteVector2(const std::vector<uint8_t> &vec);
 
+// Allocation-free variants on caller buffers, 32 bytes big endian
+uint256_t fromBytes(const uint8_t *data, size_t len);
+void toBytes(const uint256_t &val, uint8_t *out);
+uint256_t fromByteArray(const std::array<uint8_t, 32> &arr);
+std::array<uint8_t, 32> toByteArray(const uint256_t &val);
+
+// lowercase hex of len bytes into out (2*len chars, no terminator)
+void hexEncode(const uint8_t *data, size_t len, char *out);
+// 2*len hex chars into len bytes, throws std::invalid_argument on anything else
+void hexDecode(const char *hex, size_t len, uint8_t *out);
+
 #endif //QRANDOMX_BIGNUM_H
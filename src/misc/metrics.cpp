@@ -0,0 +1,230 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "misc/metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+  uint64_t doubleBits(double v)
+  {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return bits;
+  }
+
+  double bitsDouble(uint64_t bits)
+  {
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+  }
+
+  std::string formatValue(double v)
+  {
+    if (std::isinf(v))
+    {
+      return v>0 ? "+Inf" : "-Inf";
+    }
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.17g", v);
+    return buffer;
+  }
+
+  std::string seriesName(const std::string &name, const std::string &labels, const std::string &extra = "")
+  {
+    std::string all = labels;
+    if (!extra.empty())
+    {
+      all += (all.empty() ? "" : ",")+extra;
+    }
+    return all.empty() ? name : name+"{"+all+"}";
+  }
+
+  std::string escapeHelp(const std::string &help)
+  {
+    std::string out;
+    for (char c: help)
+    {
+      if (c=='\\')
+      {
+        out += "\\\\";
+      }
+      else if (c=='\n')
+      {
+        out += "\\n";
+      }
+      else
+      {
+        out += c;
+      }
+    }
+    return out;
+  }
+}
+
+MetricHistogram::MetricHistogram(const std::vector<double> &bounds)
+        : _bounds(bounds), _buckets(new std::atomic<uint64_t>[bounds.size()+1])
+{
+  if (!std::is_sorted(_bounds.begin(), _bounds.end()))
+  {
+    throw std::invalid_argument("histogram bounds must be increasing");
+  }
+  for (size_t i = 0; i<=_bounds.size(); i++)
+  {
+    _buckets[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void MetricHistogram::observe(double v)
+{
+  const auto bucket = std::lower_bound(_bounds.begin(), _bounds.end(), v)-_bounds.begin();
+  _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+  _count.fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t expected = _sum_bits.load(std::memory_order_relaxed);
+  while (!_sum_bits.compare_exchange_weak(expected, doubleBits(bitsDouble(expected)+v),
+                                          std::memory_order_relaxed))
+  {
+  }
+}
+
+std::vector<uint64_t> MetricHistogram::bucketCounts() const
+{
+  std::vector<uint64_t> counts(_bounds.size()+1);
+  for (size_t i = 0; i<counts.size(); i++)
+  {
+    counts[i] = _buckets[i].load(std::memory_order_relaxed);
+  }
+  return counts;
+}
+
+double MetricHistogram::sum() const
+{
+  return bitsDouble(_sum_bits.load(std::memory_order_relaxed));
+}
+
+std::vector<double> metricDurationBuckets()
+{
+  return {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05,
+          0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60};
+}
+
+Metrics &Metrics::instance()
+{
+  // never destroyed, so threads still running at exit can keep updating
+  static Metrics *metrics = new Metrics();
+  return *metrics;
+}
+
+Metrics::Series &Metrics::_series(const std::string &name, const std::string &help,
+                                  Type type, const std::string &labels)
+{
+  auto family = std::find_if(_families.begin(), _families.end(),
+                             [&](const Family &f) { return f.name==name; });
+  if (family==_families.end())
+  {
+    _families.push_back(Family{name, help, type, {}});
+    family = _families.end()-1;
+  }
+  else if (family->type!=type)
+  {
+    throw std::invalid_argument("metric " + name + " is registered with another type");
+  }
+
+  for (auto &series: family->series)
+  {
+    if (series.labels==labels)
+    {
+      return series;
+    }
+  }
+  family->series.emplace_back();
+  family->series.back().labels = labels;
+  return family->series.back();
+}
+
+MetricCounter &Metrics::counter(const std::string &name, const std::string &help, const std::string &labels)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto &series = _series(name, help, COUNTER, labels);
+  if (!series.counter)
+  {
+    series.counter.reset(new MetricCounter());
+  }
+  return *series.counter;
+}
+
+MetricGauge &Metrics::gauge(const std::string &name, const std::string &help, const std::string &labels)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto &series = _series(name, help, GAUGE, labels);
+  if (!series.gauge)
+  {
+    series.gauge.reset(new MetricGauge());
+  }
+  return *series.gauge;
+}
+
+MetricHistogram &Metrics::histogram(const std::string &name, const std::string &help,
+                                    const std::vector<double> &bounds, const std::string &labels)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto &series = _series(name, help, HISTOGRAM, labels);
+  if (!series.histogram)
+  {
+    series.histogram.reset(new MetricHistogram(bounds));
+  }
+  return *series.histogram;
+}
+
+std::string Metrics::prometheusText() const
+{
+  static const char *type_names[] = {"counter", "gauge", "histogram"};
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::string out;
+  for (const auto &family: _families)
+  {
+    out += "# HELP " + family.name + " " + escapeHelp(family.help) + "\n";
+    out += "# TYPE " + family.name + " " + type_names[family.type] + "\n";
+    for (const auto &series: family.series)
+    {
+      switch (family.type)
+      {
+        case COUNTER:
+          out += seriesName(family.name, series.labels) + " " + std::to_string(series.counter->value()) + "\n";
+          break;
+        case GAUGE:
+          out += seriesName(family.name, series.labels) + " " + std::to_string(series.gauge->value()) + "\n";
+          break;
+        case HISTOGRAM:
+        {
+          const auto &h = *series.histogram;
+          const auto counts = h.bucketCounts();
+          uint64_t cumulative = 0;
+          for (size_t i = 0; i<counts.size(); i++)
+          {
+            cumulative += counts[i];
+            const auto le = i<h.bounds().size() ? formatValue(h.bounds()[i]) : "+Inf";
+            out += seriesName(family.name+"_bucket", series.labels, "le=\""+le+"\"") + " "
+                   + std::to_string(cumulative) + "\n";
+          }
+          out += seriesName(family.name+"_sum", series.labels) + " " + formatValue(h.sum()) + "\n";
+          // _count matches the +Inf bucket even while observations are in flight
+          out += seriesName(family.name+"_count", series.labels) + " " + std::to_string(cumulative) + "\n";
+          break;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+std::string PrometheusMetrics()
+{
+  return Metrics::instance().prometheusText();
+}
@@ -0,0 +1,104 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_METRICS_H
+#define QRANDOMX_METRICS_H
+
+#include <string>
+
+// All metrics of the process in the Prometheus text exposition format (version 0.0.4)
+std::string PrometheusMetrics();
+
+#ifndef SWIG
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Updates are lock-free (relaxed atomics), only registering a metric takes a lock.
+// Metric objects live as long as the process, so keep the references.
+class MetricCounter {
+public:
+    void inc(uint64_t n = 1) { _value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> _value{0};
+};
+
+class MetricGauge {
+public:
+    void set(int64_t v) { _value.store(v, std::memory_order_relaxed); }
+    void add(int64_t n) { _value.fetch_add(n, std::memory_order_relaxed); }
+    int64_t value() const { return _value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> _value{0};
+};
+
+class MetricHistogram {
+public:
+    // upper bounds in increasing order, +Inf is implied
+    explicit MetricHistogram(const std::vector<double> &bounds);
+
+    void observe(double v);
+
+    const std::vector<double> &bounds() const { return _bounds; }
+    // per bucket, not cumulative; the last one is +Inf
+    std::vector<uint64_t> bucketCounts() const;
+    uint64_t count() const { return _count.load(std::memory_order_relaxed); }
+    double sum() const;
+
+private:
+    std::vector<double> _bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> _buckets;
+    std::atomic<uint64_t> _count{0};
+    std::atomic<uint64_t> _sum_bits{0};
+};
+
+// default buckets for durations in seconds, 100us to 60s
+std::vector<double> metricDurationBuckets();
+
+class Metrics {
+public:
+    static Metrics &instance();
+
+    // Returns the series registered with the same name and labels if there is one.
+    // labels is the inside of the braces, e.g. "slot=\"alt\"", or empty.
+    MetricCounter &counter(const std::string &name, const std::string &help,
+                           const std::string &labels = "");
+    MetricGauge &gauge(const std::string &name, const std::string &help,
+                       const std::string &labels = "");
+    MetricHistogram &histogram(const std::string &name, const std::string &help,
+                               const std::vector<double> &bounds = metricDurationBuckets(),
+                               const std::string &labels = "");
+
+    std::string prometheusText() const;
+
+private:
+    enum Type { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Series {
+      std::string labels;
+      std::unique_ptr<MetricCounter> counter;
+      std::unique_ptr<MetricGauge> gauge;
+      std::unique_ptr<MetricHistogram> histogram;
+    };
+
+    struct Family {
+      std::string name;
+      std::string help;
+      Type type;
+      std::deque<Series> series;
+    };
+
+    Series &_series(const std::string &name, const std::string &help, Type type, const std::string &labels);
+
+    mutable std::mutex _mutex;
+    std::deque<Family> _families;
+};
+#endif
+
+#endif //QRANDOMX_METRICS_H
@@ -0,0 +1,142 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_SIPHASH_H
+#define QRANDOMX_SIPHASH_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+// SipHash-2-4 with 128-bit output, a keyed PRF for in-memory lookup tables fed by peers:
+// without the key nobody can predict a digest, let alone build inputs that collide.
+// Use the per-process random processKey().
+class SipHash {
+public:
+    typedef std::array<uint64_t, 2> Key;
+    typedef std::array<uint64_t, 2> Digest;
+
+    explicit SipHash(const Key &key)
+            : _v0(0x736f6d6570736575ull ^ key[0]),
+              _v1(0x646f72616e646f6dull ^ key[1] ^ 0xee),
+              _v2(0x6c7967656e657261ull ^ key[0]),
+              _v3(0x7465646279746573ull ^ key[1]),
+              _tail(0), _tail_bytes(0), _length(0) {}
+
+    SipHash &update(const uint8_t *data, size_t len)
+    {
+      _length += len;
+      while (len>0 && _tail_bytes!=0)
+      {
+        _push(*data++);
+        len--;
+      }
+      for (; len>=8; data += 8, len -= 8)
+      {
+        _compress(_load(data));
+      }
+      while (len>0)
+      {
+        _push(*data++);
+        len--;
+      }
+      return *this;
+    }
+
+    SipHash &update(const std::vector<uint8_t> &data)
+    {
+      return update(data.data(), data.size());
+    }
+
+    Digest digest128() const
+    {
+      SipHash s(*this);
+      s._compress((uint64_t(s._length) << 56) | s._tail);
+      s._v2 ^= 0xee;
+      for (int i = 0; i<4; i++)
+      {
+        s._round();
+      }
+      Digest out;
+      out[0] = s._v0 ^ s._v1 ^ s._v2 ^ s._v3;
+      s._v1 ^= 0xdd;
+      for (int i = 0; i<4; i++)
+      {
+        s._round();
+      }
+      out[1] = s._v0 ^ s._v1 ^ s._v2 ^ s._v3;
+      return out;
+    }
+
+    // the first half of the 128-bit digest
+    uint64_t digest() const
+    {
+      return digest128()[0];
+    }
+
+    static const Key &processKey()
+    {
+      static const Key key = []() {
+        std::random_device rd;
+        Key k;
+        for (auto &word: k)
+        {
+          word = (uint64_t(rd()) << 32) ^ rd();
+        }
+        return k;
+      }();
+      return key;
+    }
+
+private:
+    static uint64_t _rotl(uint64_t x, int b)
+    {
+      return (x << b) | (x >> (64-b));
+    }
+
+    static uint64_t _load(const uint8_t *p)
+    {
+      uint64_t w = 0;
+      for (int i = 7; i>=0; i--)
+      {
+        w = (w << 8) | p[i];
+      }
+      return w;
+    }
+
+    void _push(uint8_t b)
+    {
+      _tail |= uint64_t(b) << (8*_tail_bytes);
+      if (++_tail_bytes==8)
+      {
+        _compress(_tail);
+        _tail = 0;
+        _tail_bytes = 0;
+      }
+    }
+
+    void _round()
+    {
+      _v0 += _v1; _v1 = _rotl(_v1, 13); _v1 ^= _v0; _v0 = _rotl(_v0, 32);
+      _v2 += _v3; _v3 = _rotl(_v3, 16); _v3 ^= _v2;
+      _v0 += _v3; _v3 = _rotl(_v3, 21); _v3 ^= _v0;
+      _v2 += _v1; _v1 = _rotl(_v1, 17); _v1 ^= _v2; _v2 = _rotl(_v2, 32);
+    }
+
+    void _compress(uint64_t m)
+    {
+      _v3 ^= m;
+      _round();
+      _round();
+      _v0 ^= m;
+    }
+
+    uint64_t _v0, _v1, _v2, _v3;
+    uint64_t _tail;
+    unsigned _tail_bytes;
+    uint64_t _length;
+};
+
+#endif //QRANDOMX_SIPHASH_H
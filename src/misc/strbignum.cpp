@@ -1,27 +1,165 @@
 // Distributed under the MIT software license, see the accompanying
 // file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 
-#include "misc/bignum.h"
+#include "misc/strbignum.h"
+#include "misc/u256.h"
+#include <algorithm>
+#include <array>
+#include <stdexcept>
 
-std::string UInt256ToString(std::vector<uint8_t> vec)
+namespace {
+  const uint64_t pow10_19 = 10000000000000000000ull;
+
+  // "00".."99", two digits per lookup
+  const std::array<char, 200> digitPairs = []() {
+    std::array<char, 200> t{};
+    for (int i = 0; i<100; i++)
+    {
+      t[2*i] = static_cast<char>('0'+i/10);
+      t[2*i+1] = static_cast<char>('0'+i%10);
+    }
+    return t;
+  }();
+
+  // value of a digit in any base up to 16, 0xFF for anything else
+  const std::array<uint8_t, 256> digitValues = []() {
+    std::array<uint8_t, 256> t{};
+    t.fill(0xFF);
+    for (int i = 0; i<10; i++)
+    {
+      t['0'+i] = static_cast<uint8_t>(i);
+    }
+    for (int i = 0; i<6; i++)
+    {
+      t['a'+i] = static_cast<uint8_t>(10+i);
+      t['A'+i] = static_cast<uint8_t>(10+i);
+    }
+    return t;
+  }();
+
+  // writes exactly 19 digits of v (< 10^19), zero padded, ending at end
+  void writeChunk(uint64_t v, char *end)
+  {
+    for (int i = 0; i<9; i++)
+    {
+      end -= 2;
+      const auto pair = static_cast<size_t>(v%100)*2;
+      end[0] = digitPairs[pair];
+      end[1] = digitPairs[pair+1];
+      v /= 100;
+    }
+    *--end = static_cast<char>('0'+v);
+  }
+
+  uint64_t power(uint64_t base, size_t exponent)
+  {
+    uint64_t p = 1;
+    while (exponent-->0)
+    {
+      p *= base;
+    }
+    return p;
+  }
+}
+
+size_t UInt256ToChars(const uint8_t *data, char *out)
+{
+  u256 value = u256::fromBigEndian(data);
+
+  // 19-digit chunks, least significant first
+  uint64_t chunks[5] = {0, 0, 0, 0, 0};
+  int count = 0;
+  do
+  {
+    uint64_t rem = 0;
+    value = u256::divmod(value, pow10_19, &rem);
+    chunks[count++] = rem;
+  } while (!value.isZero());
+
+  // the top chunk without padding, then full chunks
+  char buffer[20];
+  writeChunk(chunks[count-1], buffer+19);
+  size_t skip = 0;
+  while (skip<18 && buffer[skip]=='0')
+  {
+    skip++;
+  }
+  size_t length = 19-skip;
+  std::copy(buffer+skip, buffer+19, out);
+  for (int i = count-2; i>=0; i--)
+  {
+    writeChunk(chunks[i], out+length+19);
+    length += 19;
+  }
+  return length;
+}
+
+void CharsToUInt256(const char *s, size_t len, uint8_t *out)
+{
+  // same grammar as boost::multiprecision, which these replace
+  bool negative = false;
+  if (len>0 && s[0]=='-')
+  {
+    negative = true;
+    s++;
+    len--;
+  }
+
+  uint64_t base = 10;
+  if (len>=2 && s[0]=='0' && (s[1]=='x' || s[1]=='X'))
+  {
+    base = 16;
+    s += 2;
+    len -= 2;
+  }
+  else if (len>=1 && s[0]=='0')
+  {
+    base = 8;
+  }
+
+  // largest digit count whose value always fits in 64 bits
+  const size_t chunk_digits = base==16 ? 16 : (base==10 ? 19 : 21);
+
+  u256 value;
+  for (size_t pos = 0; pos<len; pos += chunk_digits)
+  {
+    const size_t n = std::min(chunk_digits, len-pos);
+    uint64_t chunk = 0;
+    for (size_t i = 0; i<n; i++)
+    {
+      const uint8_t digit = digitValues[static_cast<uint8_t>(s[pos+i])];
+      if (digit>=base)
+      {
+        throw std::invalid_argument("conversion was not possible");
+      }
+      chunk = chunk*base+digit;
+    }
+    // wraps modulo 2^256 like the fixed-width boost type did, 16^16 needs a shift
+    value = base==16 ? value << static_cast<unsigned>(4*n) : u256::mul(value, power(base, n));
+    value = value+u256(chunk);
+  }
+
+  if (negative)
+  {
+    value = u256()-value;
+  }
+  value.toBigEndian(out);
+}
+
+std::string UInt256ToString(const std::vector<uint8_t> &vec)
 {
   if (vec.size()!=32)
   {
     throw std::invalid_argument("vector size should be 32");
   }
 
-  uint256_t val = fromByteVector(vec);
-  return val.str();
+  char buffer[UINT256_MAX_DIGITS];
+  return std::string(buffer, UInt256ToChars(vec.data(), buffer));
 }
 
 std::vector<uint8_t> StringToUInt256(const std::string &s)
 {
-  try {
-    uint256_t val(s);
-    return toByteVector(val);
-  }
-  catch(...)
-  {
-    throw std::invalid_argument("conversion was not possible");
-  }
+  std::vector<uint8_t> tmp(32);
+  CharsToUInt256(s.data(), s.size(), tmp.data());
+  return tmp;
 }
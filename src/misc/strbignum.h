@@ -6,10 +6,23 @@
 
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 #include <exception>
 #include <string>
 
-std::string UInt256ToString(std::vector<uint8_t> vec);
+std::string UInt256ToString(const std::vector<uint8_t> &vec);
 std::vector<uint8_t> StringToUInt256(const std::string &s);
 
+#ifndef SWIG
+// longest decimal representation of a 256-bit value
+#define UINT256_MAX_DIGITS 78
+
+// Allocation-free variants on caller buffers, values are 32 bytes big endian.
+// UInt256ToChars writes at most UINT256_MAX_DIGITS chars (no terminator) and
+// returns how many. CharsToUInt256 accepts what StringToUInt256 does: decimal,
+// 0x-prefixed hex or 0-prefixed octal, taken modulo 2^256.
+size_t UInt256ToChars(const uint8_t *data, char *out);
+void CharsToUInt256(const char *s, size_t len, uint8_t *out);
+#endif
+
 #endif //QRANDOMX_STRBIGNUM_H
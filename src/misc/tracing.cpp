@@ -0,0 +1,202 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "misc/tracing.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define TRACE_RING_EVENTS 4096
+#define TRACE_MAX_EXITED_THREADS 64
+
+namespace {
+  struct TraceEvent {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    uint64_t id;
+  };
+
+  // a seqlock over relaxed atomics, only the owner of the ring writes it: sequence is
+  // 2*index+1 while span index is written and 2*index+2 once it is complete
+  struct TraceSlot {
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<const char *> name{nullptr};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> duration_ns{0};
+    std::atomic<uint64_t> id{0};
+  };
+
+  struct TraceRing {
+    uint32_t tid;
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> cleared{0};    // spans before this index were dropped by ClearTrace
+    std::atomic<bool> exited{false};
+    std::array<TraceSlot, TRACE_RING_EVENTS> slots;
+
+    void put(const TraceEvent &e)
+    {
+      const auto n = written.load(std::memory_order_relaxed);
+      auto &slot = slots[n%TRACE_RING_EVENTS];
+      slot.sequence.store(2*n+1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      slot.name.store(e.name, std::memory_order_relaxed);
+      slot.start_ns.store(e.start_ns, std::memory_order_relaxed);
+      slot.duration_ns.store(e.duration_ns, std::memory_order_relaxed);
+      slot.id.store(e.id, std::memory_order_relaxed);
+      slot.sequence.store(2*n+2, std::memory_order_release);
+      written.store(n+1, std::memory_order_release);
+    }
+
+    // false if span index was overwritten or is being written
+    bool get(uint64_t index, TraceEvent &e) const
+    {
+      const auto &slot = slots[index%TRACE_RING_EVENTS];
+      if (slot.sequence.load(std::memory_order_acquire)!=2*index+2)
+      {
+        return false;
+      }
+      e.name = slot.name.load(std::memory_order_relaxed);
+      e.start_ns = slot.start_ns.load(std::memory_order_relaxed);
+      e.duration_ns = slot.duration_ns.load(std::memory_order_relaxed);
+      e.id = slot.id.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return slot.sequence.load(std::memory_order_relaxed)==2*index+2;
+    }
+  };
+
+  struct TraceRegistry {
+    std::mutex mutex;
+    std::deque<std::shared_ptr<TraceRing>> rings;
+    uint32_t next_tid = 1;
+  };
+
+  TraceRegistry &registry()
+  {
+    // never destroyed, threads may record while the process exits
+    static TraceRegistry *r = new TraceRegistry();
+    return *r;
+  }
+
+  // registers the ring of the calling thread on first use and flags it on thread exit,
+  // the spans stay available until too many threads have exited
+  struct ThreadRing {
+    std::shared_ptr<TraceRing> ring;
+
+    ThreadRing() : ring(std::make_shared<TraceRing>())
+    {
+      auto &r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+      ring->tid = r.next_tid++;
+      r.rings.push_back(ring);
+    }
+
+    ~ThreadRing()
+    {
+      auto &r = registry();
+      std::lock_guard<std::mutex> lock(r.mutex);
+      ring->exited = true;
+      auto exited = std::count_if(r.rings.begin(), r.rings.end(),
+                                  [](const std::shared_ptr<TraceRing> &ring) { return ring->exited.load(); });
+      for (auto it = r.rings.begin(); exited>TRACE_MAX_EXITED_THREADS && it!=r.rings.end();)
+      {
+        if ((*it)->exited)
+        {
+          it = r.rings.erase(it);
+          exited--;
+        }
+        else
+        {
+          ++it;
+        }
+      }
+    }
+  };
+
+  TraceRing &threadRing()
+  {
+    thread_local ThreadRing ring;
+    return *ring.ring;
+  }
+}
+
+uint64_t qrx_trace_now(void)
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void qrx_trace_record(const char *name, uint64_t start_ns, uint64_t end_ns, uint64_t id)
+{
+  threadRing().put(TraceEvent{name, start_ns, end_ns-start_ns, id});
+}
+
+bool TracingEnabled()
+{
+#ifdef QRANDOMX_TRACING
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string ChromeTraceJson()
+{
+  std::vector<std::pair<uint32_t, std::vector<TraceEvent>>> threads;
+  {
+    auto &r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto &ring: r.rings)
+    {
+      const auto written = ring->written.load(std::memory_order_acquire);
+      const uint64_t first = std::max<uint64_t>(written>TRACE_RING_EVENTS ? written-TRACE_RING_EVENTS : 0,
+                                                ring->cleared.load(std::memory_order_relaxed));
+      // the owner keeps recording meanwhile, what it overwrites is skipped
+      std::vector<TraceEvent> events;
+      TraceEvent e;
+      for (auto i = first; i<written; i++)
+      {
+        if (ring->get(i, e))
+        {
+          events.push_back(e);
+        }
+      }
+      threads.emplace_back(ring->tid, std::move(events));
+    }
+  }
+
+  std::string out = "{\"traceEvents\":[";
+  bool first = true;
+  char buffer[256];
+  for (const auto &thread: threads)
+  {
+    for (const auto &e: thread.second)
+    {
+      std::snprintf(buffer, sizeof(buffer),
+                    "%s\n{\"name\":\"%s\",\"cat\":\"qrandomx\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                    "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"id\":%llu}}",
+                    first ? "" : ",", e.name, thread.first, e.start_ns/1e3, e.duration_ns/1e3,
+                    static_cast<unsigned long long>(e.id));
+      out += buffer;
+      first = false;
+    }
+  }
+  out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return out;
+}
+
+void ClearTrace()
+{
+  auto &r = registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (auto &ring: r.rings)
+  {
+    ring->cleared.store(ring->written.load(std::memory_order_acquire), std::memory_order_relaxed);
+  }
+}
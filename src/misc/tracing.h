@@ -0,0 +1,72 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_TRACING_H
+#define QRANDOMX_TRACING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <string>
+
+// Spans are only recorded in builds configured with QRANDOMX_TRACING=ON
+bool TracingEnabled();
+
+// The spans still held by the per-thread ring buffers in the Chrome trace event format,
+// for chrome://tracing or https://ui.perfetto.dev. Empty when tracing is compiled out.
+std::string ChromeTraceJson();
+
+void ClearTrace();
+#endif
+
+#ifndef SWIG
+// Each thread records into its own ring of TRACE_RING_EVENTS spans, the oldest ones are
+// overwritten. Names must be string literals. The macros compile to nothing by default.
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint64_t qrx_trace_now(void);
+void qrx_trace_record(const char *name, uint64_t start_ns, uint64_t end_ns, uint64_t id);
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef QRANDOMX_TRACING
+#define QRX_TRACE_START(var)            uint64_t var = qrx_trace_now()
+#define QRX_TRACE_END(var, name)        qrx_trace_record(name, var, qrx_trace_now(), 0)
+#define QRX_TRACE_END_ID(var, name, id) qrx_trace_record(name, var, qrx_trace_now(), id)
+#else
+#define QRX_TRACE_START(var)
+#define QRX_TRACE_END(var, name)
+#define QRX_TRACE_END_ID(var, name, id)
+#endif
+
+#ifdef __cplusplus
+// records the enclosing scope
+class TraceSpan {
+public:
+    explicit TraceSpan(const char *name, uint64_t id = 0) : _name(name), _id(id), _start(qrx_trace_now()) {}
+    ~TraceSpan() { qrx_trace_record(_name, _start, qrx_trace_now(), _id); }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char *_name;
+    uint64_t _id;
+    uint64_t _start;
+};
+
+#ifdef QRANDOMX_TRACING
+#define QRX_TRACE_CONCAT_(a, b) a##b
+#define QRX_TRACE_CONCAT(a, b) QRX_TRACE_CONCAT_(a, b)
+#define QRX_TRACE_SCOPE(name) TraceSpan QRX_TRACE_CONCAT(trace_span_, __LINE__)(name)
+#define QRX_TRACE_SCOPE_ID(name, id) TraceSpan QRX_TRACE_CONCAT(trace_span_, __LINE__)(name, id)
+#else
+#define QRX_TRACE_SCOPE(name)
+#define QRX_TRACE_SCOPE_ID(name, id)
+#endif
+#endif
+#endif
+
+#endif //QRANDOMX_TRACING_H
@@ -0,0 +1,524 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_U256_H
+#define QRANDOMX_U256_H
+
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+
+// Fixed-width unsigned 256-bit integer with four 64-bit limbs.
+// It never allocates and every operation is constexpr, so it can replace
+// boost::multiprecision in the difficulty/target/comparison hot paths.
+// Arithmetic wraps modulo 2^256 like the built-in unsigned types.
+class u256 {
+public:
+    // limb[0] is the least significant limb
+    uint64_t limb[4];
+
+    constexpr u256() : limb{0, 0, 0, 0} {}
+    constexpr u256(uint64_t v) : limb{v, 0, 0, 0} {}
+    constexpr u256(uint64_t l3, uint64_t l2, uint64_t l1, uint64_t l0) : limb{l0, l1, l2, l3} {}
+
+    static constexpr u256 max()
+    {
+      return u256(UINT64_MAX, UINT64_MAX, UINT64_MAX, UINT64_MAX);
+    }
+
+    ////////////////////////////////////////
+    // byte conversions (32 bytes)
+
+    static constexpr u256 fromBigEndian(const uint8_t *p)
+    {
+      u256 r;
+      for (int i = 0; i<4; i++) {
+        uint64_t v = 0;
+        for (int j = 0; j<8; j++) {
+          v = (v << 8) | p[i*8+j];
+        }
+        r.limb[3-i] = v;
+      }
+      return r;
+    }
+
+    static constexpr u256 fromLittleEndian(const uint8_t *p)
+    {
+      u256 r;
+      for (int i = 0; i<4; i++) {
+        uint64_t v = 0;
+        for (int j = 7; j>=0; j--) {
+          v = (v << 8) | p[i*8+j];
+        }
+        r.limb[i] = v;
+      }
+      return r;
+    }
+
+    constexpr void toBigEndian(uint8_t *p) const
+    {
+      for (int i = 0; i<4; i++) {
+        const uint64_t v = limb[3-i];
+        for (int j = 0; j<8; j++) {
+          p[i*8+j] = static_cast<uint8_t>(v >> (56-8*j));
+        }
+      }
+    }
+
+    constexpr void toLittleEndian(uint8_t *p) const
+    {
+      for (int i = 0; i<4; i++) {
+        const uint64_t v = limb[i];
+        for (int j = 0; j<8; j++) {
+          p[i*8+j] = static_cast<uint8_t>(v >> (8*j));
+        }
+      }
+    }
+
+    ////////////////////////////////////////
+    // queries
+
+    constexpr bool isZero() const
+    {
+      return (limb[0] | limb[1] | limb[2] | limb[3])==0;
+    }
+
+    constexpr bool fitsUInt64() const
+    {
+      return (limb[1] | limb[2] | limb[3])==0;
+    }
+
+    // number of significant bits, 0 for zero
+    constexpr unsigned bits() const
+    {
+      for (int i = 3; i>=0; i--) {
+        if (limb[i]!=0) {
+          return static_cast<unsigned>(i*64+64-clz64(limb[i]));
+        }
+      }
+      return 0;
+    }
+
+    ////////////////////////////////////////
+    // comparison
+
+    constexpr int compare(const u256 &o) const
+    {
+      for (int i = 3; i>=0; i--) {
+        if (limb[i]!=o.limb[i]) {
+          return limb[i]<o.limb[i] ? -1 : 1;
+        }
+      }
+      return 0;
+    }
+
+    friend constexpr bool operator==(const u256 &a, const u256 &b) { return a.compare(b)==0; }
+    friend constexpr bool operator!=(const u256 &a, const u256 &b) { return a.compare(b)!=0; }
+    friend constexpr bool operator<(const u256 &a, const u256 &b) { return a.compare(b)<0; }
+    friend constexpr bool operator<=(const u256 &a, const u256 &b) { return a.compare(b)<=0; }
+    friend constexpr bool operator>(const u256 &a, const u256 &b) { return a.compare(b)>0; }
+    friend constexpr bool operator>=(const u256 &a, const u256 &b) { return a.compare(b)>=0; }
+
+    ////////////////////////////////////////
+    // arithmetic
+
+    // a + b, *carry receives the carry out of the top limb
+    static constexpr u256 add(const u256 &a, const u256 &b, bool *carry = nullptr)
+    {
+      u256 r;
+      uint64_t c = 0;
+      for (int i = 0; i<4; i++) {
+        const uint64_t s = a.limb[i]+c;
+        c = s<c;
+        r.limb[i] = s+b.limb[i];
+        c += r.limb[i]<s;
+      }
+      if (carry!=nullptr) {
+        *carry = c!=0;
+      }
+      return r;
+    }
+
+    // a - b, *borrow receives the borrow out of the top limb (a < b)
+    static constexpr u256 sub(const u256 &a, const u256 &b, bool *borrow = nullptr)
+    {
+      u256 r;
+      uint64_t c = 0;
+      for (int i = 0; i<4; i++) {
+        const uint64_t d = a.limb[i]-c;
+        c = d>a.limb[i];
+        r.limb[i] = d-b.limb[i];
+        c += r.limb[i]>d;
+      }
+      if (borrow!=nullptr) {
+        *borrow = c!=0;
+      }
+      return r;
+    }
+
+    // a * m, *high receives the limb that does not fit in 256 bits
+    static constexpr u256 mul(const u256 &a, uint64_t m, uint64_t *high = nullptr)
+    {
+      u256 r;
+      uint64_t carry = 0;
+      for (int i = 0; i<4; i++) {
+        uint64_t hi = 0;
+        const uint64_t lo = mul64(a.limb[i], m, &hi);
+        r.limb[i] = lo+carry;
+        carry = hi+(r.limb[i]<lo);
+      }
+      if (high!=nullptr) {
+        *high = carry;
+      }
+      return r;
+    }
+
+    // a * b truncated to 256 bits
+    static constexpr u256 mul(const u256 &a, const u256 &b)
+    {
+      u256 r;
+      for (int i = 0; i<4; i++) {
+        uint64_t carry = 0;
+        for (int j = 0; i+j<4; j++) {
+          uint64_t hi = 0;
+          uint64_t lo = mul64(a.limb[i], b.limb[j], &hi);
+          lo += carry;
+          hi += lo<carry;
+          r.limb[i+j] += lo;
+          hi += r.limb[i+j]<lo;
+          carry = hi;
+        }
+      }
+      return r;
+    }
+
+    // a / d for a single limb divisor, *rem receives a % d
+    static constexpr u256 divmod(const u256 &a, uint64_t d, uint64_t *rem = nullptr)
+    {
+      if (d==0) {
+        throw std::invalid_argument("division by zero");
+      }
+      u256 q;
+      uint64_t r = 0;
+      for (int i = 3; i>=0; i--) {
+        q.limb[i] = div128(r, a.limb[i], d, &r);
+      }
+      if (rem!=nullptr) {
+        *rem = r;
+      }
+      return q;
+    }
+
+    // a * m / d with a 320-bit intermediate product, *overflow is set when
+    // the quotient does not fit in 256 bits (the low 256 bits are returned)
+    static constexpr u256 mulDiv(const u256 &a, uint64_t m, uint64_t d, bool *overflow = nullptr)
+    {
+      if (d==0) {
+        throw std::invalid_argument("division by zero");
+      }
+      uint64_t high = 0;
+      const u256 p = mul(a, m, &high);
+      if (overflow!=nullptr) {
+        *overflow = high>=d;
+      }
+      u256 q;
+      uint64_t r = high%d;
+      for (int i = 3; i>=0; i--) {
+        q.limb[i] = div128(r, p.limb[i], d, &r);
+      }
+      return q;
+    }
+
+    // a / b, *rem receives a % b
+    static constexpr u256 divmod(const u256 &a, const u256 &b, u256 *rem = nullptr)
+    {
+      if (b.isZero()) {
+        throw std::invalid_argument("division by zero");
+      }
+      if (a<b) {
+        if (rem!=nullptr) {
+          *rem = a;
+        }
+        return u256();
+      }
+      if (b.fitsUInt64()) {
+        uint64_t r = 0;
+        u256 q = divmod(a, b.limb[0], &r);
+        if (rem!=nullptr) {
+          *rem = u256(r);
+        }
+        return q;
+      }
+      return divmodKnuth(a, b, rem, false);
+    }
+
+    // Same results as divmod, but every quotient limb is estimated with
+    // multiplications by a precomputed reciprocal of the normalized divisor
+    // (Moller & Granlund, "Improved division by invariant integers") instead
+    // of a hardware 128/64 divide, leaving a single divide per call.
+    static constexpr u256 divmodReciprocal(const u256 &a, const u256 &b, u256 *rem = nullptr)
+    {
+      if (b.isZero()) {
+        throw std::invalid_argument("division by zero");
+      }
+      if (a<b) {
+        if (rem!=nullptr) {
+          *rem = a;
+        }
+        return u256();
+      }
+      if (!b.fitsUInt64()) {
+        return divmodKnuth(a, b, rem, true);
+      }
+
+      const uint64_t d = b.limb[0];
+      const unsigned s = clz64(d);
+      const uint64_t dn = d << s;
+      const uint64_t v = reciprocal(dn);
+
+      u256 q;
+      uint64_t r = s==0 ? 0 : a.limb[3] >> (64-s);
+      for (int i = 3; i>=0; i--) {
+        const uint64_t u = (a.limb[i] << s) | (s==0 || i==0 ? 0 : a.limb[i-1] >> (64-s));
+        q.limb[i] = div2by1(r, u, dn, v, &r);
+      }
+      if (rem!=nullptr) {
+        *rem = u256(r >> s);
+      }
+      return q;
+    }
+
+    friend constexpr u256 operator+(const u256 &a, const u256 &b) { return add(a, b); }
+    friend constexpr u256 operator-(const u256 &a, const u256 &b) { return sub(a, b); }
+    friend constexpr u256 operator*(const u256 &a, const u256 &b) { return mul(a, b); }
+    friend constexpr u256 operator/(const u256 &a, const u256 &b) { return divmod(a, b); }
+    friend constexpr u256 operator%(const u256 &a, const u256 &b)
+    {
+      u256 r;
+      divmod(a, b, &r);
+      return r;
+    }
+
+    friend constexpr u256 operator<<(const u256 &a, unsigned s)
+    {
+      u256 r;
+      if (s>=256) {
+        return r;
+      }
+      const unsigned limbs = s/64;
+      const unsigned bits = s%64;
+      for (int i = 3; i>=static_cast<int>(limbs); i--) {
+        r.limb[i] = a.limb[i-limbs] << bits;
+        if (bits!=0 && i-static_cast<int>(limbs)-1>=0) {
+          r.limb[i] |= a.limb[i-limbs-1] >> (64-bits);
+        }
+      }
+      return r;
+    }
+
+    friend constexpr u256 operator>>(const u256 &a, unsigned s)
+    {
+      u256 r;
+      if (s>=256) {
+        return r;
+      }
+      const unsigned limbs = s/64;
+      const unsigned bits = s%64;
+      for (unsigned i = 0; i+limbs<4; i++) {
+        r.limb[i] = a.limb[i+limbs] >> bits;
+        if (bits!=0 && i+limbs+1<4) {
+          r.limb[i] |= a.limb[i+limbs+1] << (64-bits);
+        }
+      }
+      return r;
+    }
+
+    ////////////////////////////////////////
+    // 64-bit helpers
+
+    static constexpr unsigned clz64(uint64_t v)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      return v==0 ? 64 : static_cast<unsigned>(__builtin_clzll(v));
+#else
+      unsigned n = 0;
+      if (v==0) {
+        return 64;
+      }
+      while ((v & (uint64_t(1) << 63))==0) {
+        v <<= 1;
+        n++;
+      }
+      return n;
+#endif
+    }
+
+    // full 64x64->128 multiplication
+    static constexpr uint64_t mul64(uint64_t a, uint64_t b, uint64_t *high)
+    {
+#if defined(__SIZEOF_INT128__)
+      const unsigned __int128 p = static_cast<unsigned __int128>(a)*b;
+      *high = static_cast<uint64_t>(p >> 64);
+      return static_cast<uint64_t>(p);
+#else
+      const uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32;
+      const uint64_t b_lo = b & 0xFFFFFFFF, b_hi = b >> 32;
+      const uint64_t p0 = a_lo*b_lo, p1 = a_lo*b_hi, p2 = a_hi*b_lo, p3 = a_hi*b_hi;
+      const uint64_t mid = (p0 >> 32)+(p1 & 0xFFFFFFFF)+(p2 & 0xFFFFFFFF);
+      *high = p3+(p1 >> 32)+(p2 >> 32)+(mid >> 32);
+      return (mid << 32) | (p0 & 0xFFFFFFFF);
+#endif
+    }
+
+    // (hi:lo) / d, requires hi < d so the quotient fits in 64 bits
+    static constexpr uint64_t div128(uint64_t hi, uint64_t lo, uint64_t d, uint64_t *rem)
+    {
+#if defined(__SIZEOF_INT128__)
+      const unsigned __int128 n = (static_cast<unsigned __int128>(hi) << 64) | lo;
+      *rem = static_cast<uint64_t>(n%d);
+      return static_cast<uint64_t>(n/d);
+#else
+      // restoring binary division, only used without a native 128-bit type
+      uint64_t q = 0;
+      for (int i = 63; i>=0; i--) {
+        const bool top = (hi >> 63)!=0;
+        hi = (hi << 1) | ((lo >> i) & 1);
+        q <<= 1;
+        if (top || hi>=d) {
+          hi -= d;
+          q |= 1;
+        }
+      }
+      *rem = hi;
+      return q;
+#endif
+    }
+
+    // floor((2^128-1)/d)-2^64 for a normalized d (high bit set)
+    static constexpr uint64_t reciprocal(uint64_t d)
+    {
+      uint64_t r = 0;
+      return div128(~d, UINT64_MAX, d, &r);
+    }
+
+    // (hi:lo) / d for a normalized d with hi < d, v = reciprocal(d)
+    static constexpr uint64_t div2by1(uint64_t hi, uint64_t lo, uint64_t d, uint64_t v, uint64_t *rem)
+    {
+      uint64_t q1 = 0;
+      uint64_t q0 = mul64(v, hi, &q1);
+      q0 += lo;
+      q1 += hi+1+(q0<lo);
+      uint64_t r = lo-q1*d;
+      if (r>q0) {
+        q1--;
+        r += d;
+      }
+      if (r>=d) {
+        q1++;
+        r -= d;
+      }
+      *rem = r;
+      return q1;
+    }
+
+private:
+    // Knuth, TAOCP vol. 2, 4.3.1 algorithm D, for divisors of two limbs or more
+    static constexpr u256 divmodKnuth(const u256 &a, const u256 &b, u256 *rem, bool use_reciprocal)
+    {
+      int n = 4;
+      while (b.limb[n-1]==0) {
+        n--;
+      }
+      int m = 4;
+      while (a.limb[m-1]==0) {
+        m--;
+      }
+
+      // normalize so the top limb of the divisor has its high bit set
+      const unsigned s = clz64(b.limb[n-1]);
+      uint64_t vn[4] = {0, 0, 0, 0};
+      uint64_t un[5] = {0, 0, 0, 0, 0};
+      for (int i = n-1; i>0; i--) {
+        vn[i] = (b.limb[i] << s) | (s==0 ? 0 : b.limb[i-1] >> (64-s));
+      }
+      vn[0] = b.limb[0] << s;
+      un[m] = s==0 ? 0 : a.limb[m-1] >> (64-s);
+      for (int i = m-1; i>0; i--) {
+        un[i] = (a.limb[i] << s) | (s==0 ? 0 : a.limb[i-1] >> (64-s));
+      }
+      un[0] = a.limb[0] << s;
+
+      const uint64_t v = use_reciprocal ? reciprocal(vn[n-1]) : 0;
+
+      u256 q;
+      for (int j = m-n; j>=0; j--) {
+        // estimate the quotient limb from the top two limbs
+        uint64_t qhat = 0;
+        uint64_t rhat = 0;
+        bool rhat_overflow = false;
+        if (un[j+n]>=vn[n-1]) {
+          qhat = UINT64_MAX;
+          rhat = un[j+n-1]+vn[n-1];
+          rhat_overflow = rhat<vn[n-1];
+        }
+        else {
+          qhat = use_reciprocal ? div2by1(un[j+n], un[j+n-1], vn[n-1], v, &rhat)
+                                : div128(un[j+n], un[j+n-1], vn[n-1], &rhat);
+        }
+        while (!rhat_overflow) {
+          uint64_t p_hi = 0;
+          const uint64_t p_lo = mul64(qhat, vn[n-2], &p_hi);
+          if (p_hi<rhat || (p_hi==rhat && p_lo<=un[j+n-2])) {
+            break;
+          }
+          qhat--;
+          rhat += vn[n-1];
+          rhat_overflow = rhat<vn[n-1];
+        }
+
+        // multiply and subtract
+        uint64_t borrow = 0;
+        uint64_t carry = 0;
+        for (int i = 0; i<n; i++) {
+          uint64_t p_hi = 0;
+          uint64_t p_lo = mul64(qhat, vn[i], &p_hi);
+          p_lo += carry;
+          p_hi += p_lo<carry;
+          carry = p_hi;
+          const uint64_t t = un[i+j]-p_lo;
+          const uint64_t b1 = t>un[i+j];
+          un[i+j] = t-borrow;
+          borrow = b1+(un[i+j]>t);
+        }
+        const uint64_t t = un[j+n]-carry;
+        const uint64_t b1 = t>un[j+n];
+        un[j+n] = t-borrow;
+        borrow = b1+(un[j+n]>t);
+
+        // the estimate was one too large, add the divisor back
+        if (borrow!=0) {
+          qhat--;
+          uint64_t c = 0;
+          for (int i = 0; i<n; i++) {
+            const uint64_t s1 = un[i+j]+c;
+            c = s1<c;
+            un[i+j] = s1+vn[i];
+            c += un[i+j]<s1;
+          }
+          un[j+n] += c;
+        }
+        q.limb[j] = qhat;
+      }
+
+      if (rem!=nullptr) {
+        u256 r;
+        for (int i = 0; i<n; i++) {
+          r.limb[i] = (un[i] >> s) | (s==0 ? 0 : un[i+1] << (64-s));
+        }
+        *rem = r;
+      }
+      return q;
+    }
+};
+
+#endif //QRANDOMX_U256_H
@@ -0,0 +1,219 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "difficultysim.h"
+#include "powhelper.h"
+#include "misc/u256.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+// keeps absurd draws (hashrate close to 0) from overflowing the measurement
+#define DIFFICULTYSIM_MAX_BLOCK_TIME 1e12
+
+namespace {
+  std::vector<uint8_t> toDifficulty(uint64_t value)
+  {
+    std::vector<uint8_t> difficulty(32);
+    u256(value).toBigEndian(difficulty.data());
+    return difficulty;
+  }
+
+  double toDouble(const std::vector<uint8_t> &difficulty)
+  {
+    double d = 0;
+    for (auto b: difficulty)
+    {
+      d = d*256+b;
+    }
+    return d;
+  }
+
+  // Welford's running mean and variance
+  class RunningStats
+  {
+  public:
+    void add(double x)
+    {
+      _n++;
+      const double delta = x-_mean;
+      _mean += delta/_n;
+      _m2 += delta*(x-_mean);
+    }
+
+    double mean() const { return _mean; }
+    double stddev() const { return _n>1 ? std::sqrt(_m2/(_n-1)) : 0; }
+
+  private:
+    uint64_t _n = 0;
+    double _mean = 0;
+    double _m2 = 0;
+  };
+
+  // same checks as PoWHelper::getDifficulty, before any worker thread starts
+  void checkParams(const std::vector<DifficultySimParams> &params)
+  {
+    for (const auto &p: params)
+    {
+      if (p.setPoint==0 || p.adjQuantization==0)
+      {
+        throw std::invalid_argument("set_point and adj_quantization should not be zero");
+      }
+    }
+  }
+
+  // block_time(i) returns the measurement of block i given its difficulty
+  template<typename BlockTime>
+  DifficultySimStats run(const DifficultySimParams &params,
+                         const DifficultySimConfig &config,
+                         uint64_t blocks,
+                         BlockTime block_time)
+  {
+    PoWHelper ph(params.kp, params.setPoint, params.adjfactLower, params.adjfactUpper, params.adjQuantization);
+
+    const uint32_t window = std::max<uint32_t>(config.window, 1);
+    const double band = config.tolerance*params.setPoint;
+
+    DifficultySimStats stats{};
+    stats.blocks = blocks;
+    stats.convergenceBlock = -1;
+
+    RunningStats block_times;
+    RunningStats difficulties;
+    std::vector<uint64_t> recent(window, 0);
+    uint64_t recent_sum = 0;
+    uint64_t last_outside = 0;
+    int last_direction = 0;
+
+    auto difficulty = toDifficulty(config.initialDifficulty);
+    double difficulty_value = toDouble(difficulty);
+    for (uint64_t i = 0; i<blocks; i++)
+    {
+      const uint64_t measurement = block_time(i, difficulty_value);
+      block_times.add(static_cast<double>(measurement));
+      difficulties.add(difficulty_value);
+
+      recent_sum += measurement-recent[i%window];
+      recent[i%window] = measurement;
+      const double average = static_cast<double>(recent_sum)/std::min<uint64_t>(i+1, window);
+      if (i+1<window || std::fabs(average-static_cast<double>(params.setPoint))>band)
+      {
+        last_outside = i+1;
+      }
+
+      difficulty = ph.getDifficulty(measurement, difficulty);
+      const double next_value = toDouble(difficulty);
+      const int direction = next_value>difficulty_value ? 1 : (next_value<difficulty_value ? -1 : 0);
+      if (direction!=0)
+      {
+        if (last_direction!=0 && direction!=last_direction)
+        {
+          stats.oscillations++;
+        }
+        last_direction = direction;
+      }
+      difficulty_value = next_value;
+    }
+
+    stats.meanBlockTime = block_times.mean();
+    stats.blockTimeStdDev = block_times.stddev();
+    stats.meanDifficulty = difficulties.mean();
+    stats.difficultyStdDev = difficulties.stddev();
+    stats.finalDifficulty = difficulty_value;
+    if (blocks>0 && last_outside<blocks)
+    {
+      stats.convergenceBlock = static_cast<int64_t>(last_outside);
+    }
+    return stats;
+  }
+
+  template<typename Run>
+  std::vector<DifficultySimStats> runAll(size_t count, uint32_t thread_count, const Run &run_one)
+  {
+    std::vector<DifficultySimStats> results(count);
+    if (thread_count==0)
+    {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // the first exception of any worker is rethrown once all of them are joined
+    std::atomic<size_t> next{0};
+    std::vector<std::exception_ptr> errors(std::min<size_t>(thread_count, count));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t<errors.size(); t++)
+    {
+      threads.emplace_back([&](size_t t) {
+        try
+        {
+          for (size_t i = next++; i<count; i = next++)
+          {
+            results[i] = run_one(i);
+          }
+        }
+        catch (...)
+        {
+          errors[t] = std::current_exception();
+          next = count;
+        }
+      }, t);
+    }
+    for (auto &thread: threads)
+    {
+      thread.join();
+    }
+    for (const auto &error: errors)
+    {
+      if (error)
+      {
+        std::rethrow_exception(error);
+      }
+    }
+    return results;
+  }
+}
+
+std::vector<DifficultySimStats> DifficultySimulator::simulate(const std::vector<DifficultySimParams> &params,
+                                                              const DifficultySimConfig &config,
+                                                              uint32_t thread_count)
+{
+  if (!(config.hashrate>0) || !(config.hashrateChangeFactor>0))
+  {
+    throw std::invalid_argument("hashrate should be positive");
+  }
+  checkParams(params);
+
+  return runAll(params.size(), thread_count, [&](size_t n) {
+    std::mt19937_64 rng(config.seed);
+    std::exponential_distribution<double> exponential(1.0);
+
+    return run(params[n], config, config.blocks, [&](uint64_t i, double difficulty) {
+      double hashrate = config.hashrate;
+      if (i>=config.hashrateChangeBlock)
+      {
+        hashrate *= config.hashrateChangeFactor;
+      }
+      const double block_time = difficulty/hashrate*exponential(rng);
+      return static_cast<uint64_t>(std::llround(std::min(block_time, DIFFICULTYSIM_MAX_BLOCK_TIME)));
+    });
+  });
+}
+
+std::vector<DifficultySimStats> DifficultySimulator::replay(const std::vector<DifficultySimParams> &params,
+                                                            const std::vector<uint64_t> &timestamps,
+                                                            const DifficultySimConfig &config,
+                                                            uint32_t thread_count)
+{
+  checkParams(params);
+  const uint64_t blocks = timestamps.empty() ? 0 : timestamps.size()-1;
+
+  return runAll(params.size(), thread_count, [&](size_t n) {
+    return run(params[n], config, blocks, [&](uint64_t i, double) {
+      // a timestamp earlier than its parent counts as a zero block time
+      return timestamps[i+1]>timestamps[i] ? timestamps[i+1]-timestamps[i] : uint64_t(0);
+    });
+  });
+}
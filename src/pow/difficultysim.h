@@ -0,0 +1,70 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_DIFFICULTYSIM_H
+#define QRANDOMX_DIFFICULTYSIM_H
+
+#include <vector>
+#include <cstdint>
+
+// PoWHelper controller parameters, same defaults as PoWHelper
+struct DifficultySimParams {
+  DifficultySimParams(int64_t kp=100,
+                      uint64_t set_point=60,
+                      int64_t adjfact_lower=-1000,
+                      int64_t adjfact_upper=+1000,
+                      int64_t adj_quantization=1024)
+          : kp(kp), setPoint(set_point), adjfactLower(adjfact_lower),
+            adjfactUpper(adjfact_upper), adjQuantization(adj_quantization) {}
+
+  int64_t kp;
+  uint64_t setPoint;
+  int64_t adjfactLower;
+  int64_t adjfactUpper;
+  int64_t adjQuantization;
+};
+
+struct DifficultySimConfig {
+  uint64_t blocks = 100000;
+  uint64_t initialDifficulty = 1000;
+  double hashrate = 100;                  // hashes per second
+  uint64_t hashrateChangeBlock = UINT64_MAX;
+  double hashrateChangeFactor = 1;        // hashrate multiplier from hashrateChangeBlock on
+  uint64_t seed = 1;
+  uint32_t window = 100;                  // blocks in the moving average block time
+  double tolerance = 0.1;                 // convergence band, fraction of the set point
+};
+
+struct DifficultySimStats {
+  uint64_t blocks;
+  double meanBlockTime;
+  double blockTimeStdDev;
+  double meanDifficulty;
+  double difficultyStdDev;
+  double finalDifficulty;
+  // first block from which the moving average block time stays within the
+  // tolerance band around the set point, -1 if it never settles
+  int64_t convergenceBlock;
+  // number of times the difficulty changed direction
+  uint64_t oscillations;
+};
+
+class DifficultySimulator {
+public:
+    // Mines config.blocks blocks against PoWHelper::getDifficulty for every parameter
+    // set, drawing block times from an exponential distribution with mean
+    // difficulty/hashrate. Parameter sets run in parallel on up to thread_count
+    // threads, 0 meaning one per core, and every set sees the same random stream.
+    static std::vector<DifficultySimStats> simulate(const std::vector<DifficultySimParams> &params,
+                                                    const DifficultySimConfig &config,
+                                                    uint32_t thread_count=0);
+
+    // Replays recorded block timestamps (seconds) through the controller. Block times
+    // are taken as given, so the statistics describe the difficulty response only.
+    static std::vector<DifficultySimStats> replay(const std::vector<DifficultySimParams> &params,
+                                                  const std::vector<uint64_t> &timestamps,
+                                                  const DifficultySimConfig &config,
+                                                  uint32_t thread_count=0);
+};
+
+#endif //QRANDOMX_DIFFICULTYSIM_H
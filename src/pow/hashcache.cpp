@@ -0,0 +1,130 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "hashcache.h"
+#include "misc/siphash.h"
+#include <algorithm>
+#include <stdexcept>
+
+// list and hash map nodes around every entry
+#define HASHCACHE_ENTRY_OVERHEAD 64
+
+HashCache::HashCache(size_t max_bytes, size_t shards)
+{
+  if (shards==0)
+  {
+    throw std::invalid_argument("at least one shard is needed");
+  }
+  for (size_t i = 0; i<shards; i++)
+  {
+    _shards.emplace_back(new Shard);
+  }
+  _shard_max_bytes = max_bytes/shards;
+}
+
+uint64_t HashCache::_digest(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input)
+{
+  return SipHash(SipHash::processKey()).update(seedHash).update(input).digest();
+}
+
+size_t HashCache::_entryBytes(const Entry &entry)
+{
+  return sizeof(Entry)+entry.input.size()+HASHCACHE_ENTRY_OVERHEAD;
+}
+
+HashCache::Shard &HashCache::_shard(uint64_t digest)
+{
+  // the low bits already pick the hash map bucket
+  return *_shards[(digest >> 32)%_shards.size()];
+}
+
+bool HashCache::get(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input,
+                    std::vector<uint8_t> &hash)
+{
+  if (seedHash.size()==32)
+  {
+    const auto digest = _digest(seedHash, input);
+    auto &shard = _shard(digest);
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(digest);
+    if (it!=shard.index.end()
+        && std::equal(seedHash.begin(), seedHash.end(), it->second->seedHash.begin())
+        && it->second->input==input)
+    {
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      hash.assign(it->second->hash.begin(), it->second->hash.end());
+      _hits++;
+      return true;
+    }
+  }
+  _misses++;
+  return false;
+}
+
+void HashCache::put(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input,
+                    const std::vector<uint8_t> &hash)
+{
+  if (seedHash.size()!=32 || hash.size()!=32)
+  {
+    return;
+  }
+
+  Entry entry;
+  entry.digest = _digest(seedHash, input);
+  std::copy(seedHash.begin(), seedHash.end(), entry.seedHash.begin());
+  entry.input = input;
+  std::copy(hash.begin(), hash.end(), entry.hash.begin());
+
+  const size_t entry_bytes = _entryBytes(entry);
+  if (entry_bytes>_shard_max_bytes)
+  {
+    return;
+  }
+
+  auto &shard = _shard(entry.digest);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  // replaces the same key, or the rare other input sharing its digest
+  auto it = shard.index.find(entry.digest);
+  if (it!=shard.index.end())
+  {
+    shard.bytes -= _entryBytes(*it->second);
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+
+  while (shard.bytes+entry_bytes>_shard_max_bytes)
+  {
+    const auto &oldest = shard.lru.back();
+    shard.bytes -= _entryBytes(oldest);
+    shard.index.erase(oldest.digest);
+    shard.lru.pop_back();
+  }
+
+  shard.lru.push_front(std::move(entry));
+  shard.index[shard.lru.front().digest] = shard.lru.begin();
+  shard.bytes += entry_bytes;
+}
+
+size_t HashCache::entries() const
+{
+  size_t count = 0;
+  for (const auto &shard: _shards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    count += shard->lru.size();
+  }
+  return count;
+}
+
+size_t HashCache::bytes() const
+{
+  size_t total = 0;
+  for (const auto &shard: _shards)
+  {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    total += shard->bytes;
+  }
+  return total;
+}
@@ -0,0 +1,65 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_HASHCACHE_H
+#define QRANDOMX_HASHCACHE_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Bounded LRU of RandomX outputs keyed by (seed hash, input), split into
+// independently locked shards so verifying threads rarely contend.
+// Lookups go through a keyed SipHash digest of the input but entries keep the full
+// input, so a digest collision is a miss and never a wrong hash.
+class HashCache
+{
+public:
+  explicit HashCache(size_t max_bytes, size_t shards = 16);
+
+  // copies the cached 32-byte output to hash and returns true on a hit
+  bool get(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input,
+           std::vector<uint8_t> &hash);
+
+  void put(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input,
+           const std::vector<uint8_t> &hash);
+
+  uint64_t hits() const { return _hits; }
+  uint64_t misses() const { return _misses; }
+  size_t entries() const;
+  size_t bytes() const;
+  size_t maxBytes() const { return _shard_max_bytes*_shards.size(); }
+
+protected:
+  struct Entry
+  {
+    uint64_t digest;
+    std::array<uint8_t, 32> seedHash;
+    std::vector<uint8_t> input;
+    std::array<uint8_t, 32> hash;
+  };
+
+  struct Shard
+  {
+    std::mutex mutex;
+    std::list<Entry> lru;   // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t bytes = 0;
+  };
+
+  static uint64_t _digest(const std::vector<uint8_t> &seedHash, const std::vector<uint8_t> &input);
+  static size_t _entryBytes(const Entry &entry);
+  Shard &_shard(uint64_t digest);
+
+  std::vector<std::unique_ptr<Shard>> _shards;
+  size_t _shard_max_bytes;
+  std::atomic<uint64_t> _hits{0};
+  std::atomic<uint64_t> _misses{0};
+};
+
+#endif //QRANDOMX_HASHCACHE_H
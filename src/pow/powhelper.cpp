@@ -23,10 +23,73 @@
 
 #include "powhelper.h"
 #include "qrandomx/qrandomxpool.h"
-#include "misc/bignum.h"
+#include "qrandomx/qrandomx.h"
+#include "misc/u256.h"
+#include "misc/siphash.h"
+#include "targetscan.h"
+#include "targetcache.h"
+#include "hashcache.h"
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#define DUPLICATE_CACHE_ENTRIES 4096
 
 std::shared_ptr<QRandomXPool> PoWHelper::_qrxpool = std::make_shared<QRandomXPool>();
 
+// Direct-mapped table holding the digests of recently rejected inputs: one half of a
+// keyed SipHash picks the slot, the other half is stored. A new rejection overwrites
+// whatever older one shares its slot.
+class PoWDuplicateCache
+{
+public:
+  explicit PoWDuplicateCache(size_t entries)
+  {
+    size_t size = 1;
+    while (size<entries)
+    {
+      size <<= 1;
+    }
+    _slots.reset(new std::atomic<uint64_t>[size]);
+    for (size_t i = 0; i<size; i++)
+    {
+      _slots[i].store(0, std::memory_order_relaxed);
+    }
+    _mask = size-1;
+  }
+
+  // seed hash and target are both 32 bytes, so the concatenation is unambiguous
+  static SipHash::Digest digest(const std::vector<uint8_t>& seedHash,
+                                const std::vector<uint8_t>& input,
+                                const std::vector<uint8_t>& target)
+  {
+    auto d = SipHash(SipHash::processKey()).update(seedHash).update(input).update(target).digest128();
+    if (d[1]==0)
+    {
+      d[1] = 1;   // 0 marks an empty slot
+    }
+    return d;
+  }
+
+  bool contains(const SipHash::Digest &d) const
+  {
+    return _slots[d[0] & _mask].load(std::memory_order_relaxed)==d[1];
+  }
+
+  void insert(const SipHash::Digest &d)
+  {
+    _slots[d[0] & _mask].store(d[1], std::memory_order_relaxed);
+  }
+
+private:
+  std::unique_ptr<std::atomic<uint64_t>[]> _slots;
+  size_t _mask;
+};
+
 PoWHelper::PoWHelper(int64_t kp,
                      uint64_t set_point,
                      int64_t adjfact_lower,
@@ -36,62 +99,183 @@ PoWHelper::PoWHelper(int64_t kp,
           _set_point(set_point),
           _adjfact_lower(adjfact_lower),
           _adjfact_upper(adjfact_upper),
-          _adj_quantization(adj_quantization)
+          _adj_quantization(adj_quantization),
+          _min_input_length(0),
+          _max_input_length(std::numeric_limits<size_t>::max()),
+          _nonce_offset_enabled(false),
+          _nonce_offset(0),
+          _duplicates(std::make_shared<PoWDuplicateCache>(DUPLICATE_CACHE_ENTRIES))
 {
 }
 
-std::vector<uint8_t> PoWHelper::getDifficulty(uint64_t measurement,
-                                              const std::vector<uint8_t> &parent_difficulty_vec)
+void PoWHelper::setInputLength(size_t min_length, size_t max_length)
 {
-  const uint256_t _difficulty_lower_bound = 2;                                // To avoid issues with the target
-  const uint256_t _difficulty_upper_bound = std::numeric_limits<uint256_t>::max();
+  if (min_length>max_length)
+  {
+    throw std::invalid_argument("min_length should not exceed max_length");
+  }
+  _min_input_length = min_length;
+  _max_input_length = max_length;
+}
 
-  // calculate adjustment factor and apply boundaries
+void PoWHelper::setNonceOffset(uint32_t nonce_offset)
+{
+  _nonce_offset_enabled = true;
+  _nonce_offset = nonce_offset;
+}
 
-  const auto tmp_val = static_cast<const long>(((double) _Kp) - (double)_Kp*(double)measurement/(double)_set_point);
+void PoWHelper::setDuplicateCacheSize(size_t entries)
+{
+  _duplicates = entries>0 ? std::make_shared<PoWDuplicateCache>(entries) : nullptr;
+}
 
-  bigint adjustment = bigint(tmp_val);
+void PoWHelper::setHashCacheSize(size_t max_bytes)
+{
+  _hash_cache = max_bytes>0 ? std::make_shared<HashCache>(max_bytes) : nullptr;
+}
 
-  if (adjustment > _adjfact_upper)
+PoWHashCacheStats PoWHelper::hashCacheStats() const
+{
+  PoWHashCacheStats stats{};
+  auto hash_cache = _hash_cache;
+  if (hash_cache)
   {
-    adjustment = bigint(_adjfact_upper);
+    stats.hits = hash_cache->hits();
+    stats.misses = hash_cache->misses();
+    stats.entries = hash_cache->entries();
+    stats.bytes = hash_cache->bytes();
+    stats.maxBytes = hash_cache->maxBytes();
   }
-  if (adjustment < _adjfact_lower)
+  return stats;
+}
+
+PoWPrecheck PoWHelper::precheckInput(const std::vector<uint8_t>& seedHash,
+                                     const std::vector<uint8_t>& input,
+                                     const std::vector<uint8_t>& target) const
+{
+  if (input.size()<_min_input_length || input.size()>_max_input_length)
   {
-    adjustment = bigint(_adjfact_lower);
+    return PRECHECK_BAD_LENGTH;
   }
+  if (_nonce_offset_enabled && (input.size()<4 || _nonce_offset>input.size()-4))
+  {
+    return PRECHECK_BAD_NONCE_OFFSET;
+  }
+  // nothing but an all-zero hash could meet a zero target
+  if (target.size()!=32 || std::all_of(target.begin(), target.end(), [](uint8_t b) { return b==0; }))
+  {
+    return PRECHECK_BAD_TARGET;
+  }
+  if (seedHash.size()!=32)
+  {
+    return PRECHECK_BAD_SEED;
+  }
+  if (_duplicates && _duplicates->contains(PoWDuplicateCache::digest(seedHash, input, target)))
+  {
+    return PRECHECK_DUPLICATE;
+  }
+  return PRECHECK_OK;
+}
 
-  uint256_t parent_difficulty = fromByteVector(parent_difficulty_vec);
-  bigint difficulty_delta = (parent_difficulty * adjustment) / _adj_quantization;
-
-  if (difficulty_delta == 0 &&  adjustment != 0){
-    difficulty_delta = adjustment < 0 ? -1 : 1;
+namespace {
+  uint64_t magnitude(int64_t v)
+  {
+    return v<0 ? uint64_t(0)-uint64_t(v) : uint64_t(v);
   }
 
-  // calculate difficulty and apply boundaries
-  bigint difficulty = parent_difficulty + difficulty_delta;
+  // trunc(kp - kp*measurement/set_point) clamped to [lower, upper], computed exactly
+  // as trunc(kp*(set_point-measurement)/set_point)
+  int64_t adjustmentFactor(int64_t kp, uint64_t measurement, uint64_t set_point,
+                           int64_t lower, int64_t upper)
+  {
+    const bool late = measurement>set_point;
+    const uint64_t distance = late ? measurement-set_point : set_point-measurement;
+    const bool negative = (kp<0)!=late;
 
-  difficulty = std::max<bigint>(difficulty, _difficulty_lower_bound);
-  difficulty = std::min<bigint>(difficulty, _difficulty_upper_bound);
+    // |kp|*distance < 2^128, so the quotient only needs the two low limbs
+    const u256 q = u256::mulDiv(u256(magnitude(kp)), distance, set_point);
 
-  return toByteVector(uint256_t(difficulty));
+    int64_t adjustment;
+    if (q.limb[1]!=0 || q.limb[0]>uint64_t(INT64_MAX))
+    {
+      adjustment = negative ? INT64_MIN : INT64_MAX;
+    }
+    else
+    {
+      adjustment = negative ? -static_cast<int64_t>(q.limb[0]) : static_cast<int64_t>(q.limb[0]);
+    }
+    return std::min(std::max(adjustment, lower), upper);
+  }
 }
 
-std::vector<uint8_t> PoWHelper::getTarget(const std::vector<uint8_t> &difficulty_vec)
+std::vector<uint8_t> PoWHelper::getDifficulty(uint64_t measurement,
+                                              const std::vector<uint8_t> &parent_difficulty_vec)
 {
-  std::vector<uint8_t> boundary(32, 0);
+  const u256 difficulty_lower_bound = 2;  // To avoid issues with the target
+
+  if (parent_difficulty_vec.size()!=32)
+  {
+    throw std::invalid_argument("vector size should be 32");
+  }
+  if (_set_point==0 || _adj_quantization==0)
+  {
+    throw std::invalid_argument("set_point and adj_quantization should not be zero");
+  }
+
+  // calculate adjustment factor and apply boundaries
+  const int64_t adjustment = adjustmentFactor(_Kp, measurement, _set_point, _adjfact_lower, _adjfact_upper);
+
+  // difficulty_delta = trunc(parent_difficulty * adjustment / adj_quantization)
+  const u256 parent_difficulty = u256::fromBigEndian(parent_difficulty_vec.data());
+  bool delta_overflow = false;
+  u256 delta = u256::mulDiv(parent_difficulty, magnitude(adjustment), magnitude(_adj_quantization), &delta_overflow);
+  bool delta_negative = (adjustment<0)!=(_adj_quantization<0);
+
+  if (delta.isZero() && !delta_overflow && adjustment!=0)
+  {
+    delta = 1;
+    delta_negative = adjustment<0;
+  }
 
-  auto difficulty = fromByteVector(difficulty_vec);
+  // calculate difficulty and apply boundaries
+  u256 difficulty;
+  if (delta_negative)
+  {
+    bool borrow = false;
+    difficulty = u256::sub(parent_difficulty, delta, &borrow);
+    if (borrow || delta_overflow)
+    {
+      difficulty = difficulty_lower_bound;
+    }
+  }
+  else
+  {
+    bool carry = false;
+    difficulty = u256::add(parent_difficulty, delta, &carry);
+    if (carry || delta_overflow)
+    {
+      difficulty = u256::max();
+    }
+  }
+  difficulty = std::max(difficulty, difficulty_lower_bound);
 
-  if (difficulty == 0)
-    return boundary;
+  std::vector<uint8_t> difficulty_vec(32);
+  difficulty.toBigEndian(difficulty_vec.data());
+  return difficulty_vec;
+}
 
-  bigint max_boundary = (bigint(1) << 256)-bigint(1);
-  uint256_t tmp2 = uint256_t(max_boundary/bigint(difficulty));
+std::vector<uint8_t> PoWHelper::getTarget(const std::vector<uint8_t> &difficulty_vec)
+{
+  if (difficulty_vec.size()!=32)
+  {
+    throw std::invalid_argument("vector size should be 32");
+  }
 
-  auto byteVector = toByteVector(tmp2);
-  std::reverse(byteVector.begin(), byteVector.end());
-  return byteVector;
+  std::vector<uint8_t> boundary(32, 0);
+
+  // the target is little endian (Monero) while the difficulty is big endian
+  TargetCache::target(u256::fromBigEndian(difficulty_vec.data())).toLittleEndian(boundary.data());
+  return boundary;
 }
 
 bool PoWHelper::passesTarget(const std::vector<uint8_t> &hash, const std::vector<uint8_t> &target)
@@ -103,18 +287,119 @@ bool PoWHelper::passesTarget(const std::vector<uint8_t> &hash, const std::vector
     return false;
   }
 
-  for(size_t i = 0; i < 32; i++)
+  return passesTargetSIMD(hash.data(), target.data());
+}
+
+namespace {
+  size_t batchCount(size_t hashes_len, size_t values_len, size_t bitmap_len)
+  {
+    if (hashes_len%32!=0 || values_len%32!=0)
+    {
+      throw std::invalid_argument("buffer size should be a multiple of 32");
+    }
+    const size_t count = hashes_len/32;
+    if (values_len!=32 && values_len!=hashes_len)
+    {
+      throw std::invalid_argument("expected one value per hash or a single value");
+    }
+    if (bitmap_len<(count+7)/8)
+    {
+      throw std::invalid_argument("bitmap is too small");
+    }
+    return count;
+  }
+
+  // runs work on thread_count threads that pull indices 0..count-1 from a shared counter
+  void parallelFor(size_t count, uint32_t thread_count,
+                   const std::function<void(const std::function<bool(size_t&)>&)> &work)
   {
-    const uint8_t h = hash[31-i];
-    const uint8_t t = target[31-i];
-    if (h > t)
-      return false;
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    const auto workers = std::min<size_t>(thread_count, count);
+    for (size_t t = 0; t<workers; t++)
+    {
+      threads.emplace_back([&]() {
+        work([&](size_t &i) { i = next++; return i<count; });
+      });
+    }
+    for (auto &thread: threads)
+    {
+      thread.join();
+    }
+  }
+
+  // batches rarely repeat a difficulty (it changes every block), so they skip the TargetCache
+  u256 targetFromDifficulty(const uint8_t *difficulty)
+  {
+    const auto d = u256::fromBigEndian(difficulty);
+    return d.isZero() ? u256() : u256::divmodReciprocal(u256::max(), d);
+  }
+}
+
+void PoWHelper::passesTargets(const uint8_t *hashes, size_t hashes_len,
+                              const uint8_t *targets, size_t targets_len,
+                              uint8_t *bitmap, size_t bitmap_len)
+{
+  const size_t count = batchCount(hashes_len, targets_len, bitmap_len);
+  const size_t target_stride = targets_len==32 ? 0 : 32;
+
+  std::fill(bitmap, bitmap+(count+7)/8, 0);
+  for (size_t i = 0; i<count; i++)
+  {
+    if (passesTargetSIMD(hashes+i*32, targets+i*target_stride))
+    {
+      bitmap[i/8] |= uint8_t(1u << (i%8));
+    }
+  }
+}
+
+void PoWHelper::passesDifficulties(const uint8_t *hashes, size_t hashes_len,
+                                   const uint8_t *difficulties, size_t difficulties_len,
+                                   uint8_t *bitmap, size_t bitmap_len)
+{
+  const size_t count = batchCount(hashes_len, difficulties_len, bitmap_len);
+  const size_t difficulty_stride = difficulties_len==32 ? 0 : 32;
+
+  std::fill(bitmap, bitmap+(count+7)/8, 0);
+  u256 target = targetFromDifficulty(difficulties);
+  for (size_t i = 0; i<count; i++)
+  {
+    if (difficulty_stride!=0 && i>0)
+    {
+      target = targetFromDifficulty(difficulties+i*difficulty_stride);
+    }
+    if (u256::fromLittleEndian(hashes+i*32)<=target)
+    {
+      bitmap[i/8] |= uint8_t(1u << (i%8));
+    }
+  }
+}
 
-    if (h < t)
-      return true;
+std::vector<uint32_t> PoWHelper::scanTarget(const uint8_t *hashes, size_t hashes_len,
+                                            const uint8_t *target, size_t target_len)
+{
+  if (hashes_len%32!=0 || target_len!=32)
+  {
+    throw std::invalid_argument("expected 32-byte hashes and a 32-byte target");
   }
 
-  return true;  // they are equal
+  std::vector<uint32_t> indices(hashes_len/32);
+  indices.resize(::scanTarget(hashes, hashes_len/32, target, indices.data()));
+  return indices;
+}
+
+void PoWHelper::getTargets(const uint8_t *difficulties, size_t difficulties_len,
+                           uint8_t *targets, size_t targets_len)
+{
+  if (difficulties_len%32!=0 || targets_len<difficulties_len)
+  {
+    throw std::invalid_argument("target buffer should hold 32 bytes per difficulty");
+  }
+
+  for (size_t i = 0; i<difficulties_len; i += 32)
+  {
+    targetFromDifficulty(difficulties+i).toLittleEndian(targets+i);
+  }
 }
 
 bool PoWHelper::verifyInput(uint64_t mainHeight,
@@ -123,7 +408,177 @@ bool PoWHelper::verifyInput(uint64_t mainHeight,
                             const std::vector<uint8_t> &input,
                             const std::vector<uint8_t> &target)
 {
-  auto qrx = _qrxpool->acquire();
-  auto hash = qrx->hash(mainHeight, seedHeight, seedHash, input, 0, 1);
-  return passesTarget(hash, target);
+  if (precheckInput(seedHash, input, target)!=PRECHECK_OK)
+  {
+    return false;
+  }
+
+  std::vector<uint8_t> hash;
+  auto hash_cache = _hash_cache;
+  if (!hash_cache || !hash_cache->get(seedHash, input, hash))
+  {
+    auto qrx = _qrxpool->acquire();
+    hash = qrx->hash(mainHeight, seedHeight, seedHash, input, 0, 1);
+    if (hash_cache)
+    {
+      hash_cache->put(seedHash, input, hash);
+    }
+  }
+
+  if (passesTarget(hash, target))
+  {
+    return true;
+  }
+
+  auto duplicates = _duplicates;
+  if (duplicates)
+  {
+    duplicates->insert(PoWDuplicateCache::digest(seedHash, input, target));
+  }
+  return false;
+}
+
+std::vector<uint8_t> PoWHelper::verifyInputs(const std::vector<PoWVerifyItem>& items,
+                                             uint32_t thread_count)
+{
+  std::vector<uint8_t> results(items.size(), 0);
+  std::vector<std::vector<uint8_t>> hashes(items.size());
+  std::vector<size_t> checked;
+  std::vector<size_t> hashed;
+
+  if (thread_count==0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  // group by seed, items failing the prechecks are never hashed
+  auto hash_cache = _hash_cache;
+  std::map<std::pair<uint64_t, std::vector<uint8_t>>, std::vector<size_t>> seeds;
+  for (size_t i = 0; i<items.size(); i++)
+  {
+    const auto &item = items[i];
+    if (precheckInput(item.seedHash, item.input, item.target)!=PRECHECK_OK)
+    {
+      continue;
+    }
+    checked.push_back(i);
+    if (!hash_cache || !hash_cache->get(item.seedHash, item.input, hashes[i]))
+    {
+      seeds[std::make_pair(item.seedHeight, item.seedHash)].push_back(i);
+      hashed.push_back(i);
+    }
+  }
+
+  for (const auto &seed: seeds)
+  {
+    std::vector<size_t> mainchain;
+    std::vector<size_t> batch;
+    for (auto i: seed.second)
+    {
+      const auto &item = items[i];
+      if (QRandomX::seedCached(item.mainHeight, item.seedHeight, item.seedHash))
+      {
+        mainchain.push_back(i);
+      }
+      else
+      {
+        batch.push_back(i);
+      }
+    }
+
+    parallelFor(mainchain.size(), thread_count, [&](const std::function<bool(size_t&)> &next) {
+      auto qrx = _qrxpool->acquire();
+      size_t n;
+      while (next(n))
+      {
+        const auto &item = items[mainchain[n]];
+        hashes[mainchain[n]] = qrx->hash(item.mainHeight, item.seedHeight, item.seedHash, item.input, 0, 1);
+      }
+    });
+
+    if (!batch.empty())
+    {
+      QRandomXBatch qrx(seed.first.first, seed.first.second);
+      parallelFor(batch.size(), thread_count, [&](const std::function<bool(size_t&)> &next) {
+        size_t n;
+        while (next(n))
+        {
+          hashes[batch[n]] = qrx.hash(items[batch[n]].input);
+        }
+        QRandomXBatch::freeVM();
+      });
+    }
+  }
+
+  if (hash_cache)
+  {
+    for (auto i: hashed)
+    {
+      hash_cache->put(items[i].seedHash, items[i].input, hashes[i]);
+    }
+  }
+
+  auto duplicates = _duplicates;
+  for (auto i: checked)
+  {
+    const auto &item = items[i];
+    results[i] = passesTarget(hashes[i], item.target);
+    if (!results[i] && duplicates)
+    {
+      duplicates->insert(PoWDuplicateCache::digest(item.seedHash, item.input, item.target));
+    }
+  }
+
+  return results;
+}
+
+void PoWHelper::hashBatch(uint64_t mainHeight, uint64_t seedHeight,
+                          const uint8_t *seedHash, size_t seedHash_len,
+                          const uint8_t *inputs, size_t inputs_len, size_t input_size,
+                          uint8_t *outputs, size_t outputs_len,
+                          uint32_t thread_count)
+{
+  if (seedHash_len!=32)
+  {
+    throw std::invalid_argument("seedHash must be 32 bytes");
+  }
+  if (input_size==0 || inputs_len%input_size!=0)
+  {
+    throw std::invalid_argument("inputs must be a multiple of input_size bytes");
+  }
+  const size_t count = inputs_len/input_size;
+  if (outputs_len<count*32)
+  {
+    throw std::invalid_argument("outputs must hold 32 bytes per input");
+  }
+
+  if (thread_count==0)
+  {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  const std::vector<uint8_t> seed(seedHash, seedHash+32);
+  if (QRandomX::seedCached(mainHeight, seedHeight, seed))
+  {
+    parallelFor(count, thread_count, [&](const std::function<bool(size_t&)> &next) {
+      auto qrx = _qrxpool->acquire();
+      size_t n;
+      while (next(n))
+      {
+        qrx->hashInto(mainHeight, seedHeight, seedHash, 32, inputs+n*input_size, input_size, outputs+n*32, 32, 0, 1);
+      }
+    });
+  }
+  else if (count>0)
+  {
+    QRandomXBatch qrx(seedHeight, seed);
+    parallelFor(count, thread_count, [&](const std::function<bool(size_t&)> &next) {
+      size_t n;
+      while (next(n))
+      {
+        qrx.hash(inputs+n*input_size, input_size, outputs+n*32);
+      }
+      QRandomXBatch::freeVM();
+    });
+  }
 }
@@ -30,6 +30,43 @@
 #include <memory>
 
 class QRandomXPool; // forward-declare this class to keep swig from including
+class PoWDuplicateCache;
+class HashCache;
+
+struct PoWHashCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t entries;
+  uint64_t bytes;
+  uint64_t maxBytes;
+};
+
+enum PoWPrecheck {
+  PRECHECK_OK = 0,
+  PRECHECK_BAD_LENGTH = 1,
+  PRECHECK_BAD_NONCE_OFFSET = 2,
+  PRECHECK_BAD_TARGET = 3,
+  PRECHECK_BAD_SEED = 4,
+  PRECHECK_DUPLICATE = 5
+};
+
+struct PoWVerifyItem {
+  PoWVerifyItem() : mainHeight(0), seedHeight(0) {}
+
+  PoWVerifyItem(uint64_t mainHeight,
+                uint64_t seedHeight,
+                const std::vector<uint8_t>& seedHash,
+                const std::vector<uint8_t>& input,
+                const std::vector<uint8_t>& target)
+          : mainHeight(mainHeight), seedHeight(seedHeight),
+            seedHash(seedHash), input(input), target(target) {}
+
+  uint64_t mainHeight;
+  uint64_t seedHeight;
+  std::vector<uint8_t> seedHash;
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> target;
+};
 
 class PoWHelper {
 public:
@@ -49,12 +86,72 @@ public:
     std::vector<uint8_t> getTarget(const std::vector<uint8_t> &difficulty);
 
     static bool passesTarget(const std::vector<uint8_t> &hash, const std::vector<uint8_t> &target);
+
+    // Batch checks over contiguous arrays of 32-byte values, e.g. a chunk of headers during sync.
+    // hashes and targets are little endian, difficulties big endian. targets/difficulties hold
+    // either one value per hash or a single value shared by all of them. Bit i of bitmap
+    // (least significant bit first, (count+7)/8 bytes) is set when hash i passes.
+    static void passesTargets(const uint8_t *hashes, size_t hashes_len,
+                              const uint8_t *targets, size_t targets_len,
+                              uint8_t *bitmap, size_t bitmap_len);
+
+    static void passesDifficulties(const uint8_t *hashes, size_t hashes_len,
+                                   const uint8_t *difficulties, size_t difficulties_len,
+                                   uint8_t *bitmap, size_t bitmap_len);
+
+    // indices of the hashes (contiguous 32-byte little endian values) that pass a single target
+    static std::vector<uint32_t> scanTarget(const uint8_t *hashes, size_t hashes_len,
+                                            const uint8_t *target, size_t target_len);
+
+    // writes the little endian target of every big endian difficulty
+    static void getTargets(const uint8_t *difficulties, size_t difficulties_len,
+                           uint8_t *targets, size_t targets_len);
+
+    // Limits enforced by precheckInput. By default any length is accepted and the nonce
+    // offset is not checked; with a nonce offset the 4-byte nonce has to fit in the input.
+    void setInputLength(size_t min_length, size_t max_length);
+    void setNonceOffset(uint32_t nonce_offset);
+
+    // number of rejected inputs remembered so that repeats fail without hashing, 0 disables
+    // it. Not thread-safe, configure before verifying.
+    void setDuplicateCacheSize(size_t entries);
+
+    // Keeps RandomX outputs by (seed hash, input) so that verifying a header again, e.g. when
+    // it arrives from another peer or after a reorg, is a lookup. Disabled by default, 0 bytes
+    // disables it again. Not thread-safe, configure before verifying.
+    void setHashCacheSize(size_t max_bytes);
+
+    PoWHashCacheStats hashCacheStats() const;
+
+    // Structural checks that verifyInput/verifyInputs run before touching a VM:
+    // input length, nonce offset, a non-zero 32-byte target, a 32-byte seed hash and
+    // whether the same (seed, input, target) was rejected recently.
+    PoWPrecheck precheckInput(const std::vector<uint8_t>& seedHash,
+                              const std::vector<uint8_t>& input,
+                              const std::vector<uint8_t>& target) const;
+
     bool verifyInput(uint64_t mainHeight,
                      uint64_t seedHeight,
                      const std::vector<uint8_t>& seedHash,
                      const std::vector<uint8_t>& input,
                      const std::vector<uint8_t>& target);
 
+    // Verifies a batch (e.g. headers received during sync) on up to thread_count threads,
+    // 0 meaning one per core. Items are grouped by seed: seeds held by the mainchain cache
+    // are hashed there, others on a dedicated cache initialized once per seed, so neither
+    // serializes on the alt slot. Returns 1 for every item that passes its target, else 0.
+    std::vector<uint8_t> verifyInputs(const std::vector<PoWVerifyItem>& items,
+                                      uint32_t thread_count=0);
+
+    // Hashes inputs_len/input_size blobs of input_size bytes each (e.g. the rows of a 2-D
+    // array) with one seed on up to thread_count threads, 0 meaning one per core, and writes
+    // the 32-byte results back to back into outputs.
+    static void hashBatch(uint64_t mainHeight, uint64_t seedHeight,
+                          const uint8_t *seedHash, size_t seedHash_len,
+                          const uint8_t *inputs, size_t inputs_len, size_t input_size,
+                          uint8_t *outputs, size_t outputs_len,
+                          uint32_t thread_count=0);
+
 private:
     int64_t _Kp;
     uint64_t _set_point;
@@ -62,6 +159,13 @@ private:
     int64_t _adjfact_upper;
     int64_t _adj_quantization;
 
+    size_t _min_input_length;
+    size_t _max_input_length;
+    bool _nonce_offset_enabled;
+    uint32_t _nonce_offset;
+    std::shared_ptr<PoWDuplicateCache> _duplicates;
+    std::shared_ptr<HashCache> _hash_cache;
+
     static std::shared_ptr<QRandomXPool> _qrxpool;
 };
 
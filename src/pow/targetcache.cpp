@@ -0,0 +1,84 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "targetcache.h"
+
+TargetCache::TargetCache()
+{
+  for (auto &slot: _slots)
+  {
+    slot.sequence.store(0, std::memory_order_relaxed);
+    for (int i = 0; i<4; i++)
+    {
+      slot.difficulty[i].store(0, std::memory_order_relaxed);
+      slot.target[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+size_t TargetCache::_index(const u256 &difficulty)
+{
+  const uint64_t h = (difficulty.limb[0] ^ difficulty.limb[1] ^ difficulty.limb[2] ^ difficulty.limb[3])
+                     *0x9E3779B97F4A7C15ull;
+  return static_cast<size_t>(h >> 58)%SLOTS;
+}
+
+bool TargetCache::get(const u256 &difficulty, u256 &target) const
+{
+  const Slot &slot = _slots[_index(difficulty)];
+
+  const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+  if (sequence==0 || (sequence & 1)!=0)
+  {
+    return false;
+  }
+
+  // loaded straight into target, going through a local copy costs a store-forwarding stall
+  bool match = true;
+  for (int i = 0; i<4; i++)
+  {
+    match &= slot.difficulty[i].load(std::memory_order_relaxed)==difficulty.limb[i];
+    target.limb[i] = slot.target[i].load(std::memory_order_relaxed);
+  }
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return match && slot.sequence.load(std::memory_order_relaxed)==sequence;
+}
+
+void TargetCache::put(const u256 &difficulty, const u256 &target)
+{
+  Slot &slot = _slots[_index(difficulty)];
+
+  // another writer owns the slot, leave it to them
+  uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+  if ((sequence & 1)!=0 || !slot.sequence.compare_exchange_strong(sequence, sequence+1, std::memory_order_relaxed))
+  {
+    return;
+  }
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (int i = 0; i<4; i++)
+  {
+    slot.difficulty[i].store(difficulty.limb[i], std::memory_order_relaxed);
+    slot.target[i].store(target.limb[i], std::memory_order_relaxed);
+  }
+  slot.sequence.store(sequence+2, std::memory_order_release);
+}
+
+u256 TargetCache::target(const u256 &difficulty)
+{
+  static TargetCache cache;
+
+  if (difficulty.isZero())
+  {
+    return u256();
+  }
+
+  u256 target;
+  if (!cache.get(difficulty, target))
+  {
+    target = u256::divmodReciprocal(u256::max(), difficulty);
+    cache.put(difficulty, target);
+  }
+  return target;
+}
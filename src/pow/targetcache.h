@@ -0,0 +1,42 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_TARGETCACHE_H
+#define QRANDOMX_TARGETCACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include "misc/u256.h"
+
+// Small direct-mapped memo of difficulty -> target for the handful of
+// difficulties miners and pools keep asking about. Every slot is a seqlock
+// over relaxed atomics: readers never block, and a reader racing a writer
+// simply misses and computes the target itself.
+class TargetCache
+{
+public:
+  static const size_t SLOTS = 64;
+
+  TargetCache();
+
+  // target is overwritten even on a miss
+  bool get(const u256 &difficulty, u256 &target) const;
+  void put(const u256 &difficulty, const u256 &target);
+
+  // (2^256-1)/difficulty, 0 for a zero difficulty, through the process wide cache
+  static u256 target(const u256 &difficulty);
+
+protected:
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence;  // odd while a writer owns the slot
+    std::atomic<uint64_t> difficulty[4];
+    std::atomic<uint64_t> target[4];
+  };
+
+  static size_t _index(const u256 &difficulty);
+
+  Slot _slots[SLOTS];
+};
+
+#endif //QRANDOMX_TARGETCACHE_H
@@ -0,0 +1,118 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "targetscan.h"
+#include "misc/u256.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// The vector versions compare all 32 bytes at once and build two masks: the
+// bytes where hash > target and the bytes where hash < target. Bit i of a mask
+// stands for byte i, which has weight 256^i, so the most significant
+// differing byte decides and hash <= target exactly when gt <= lt.
+
+bool passesTargetScalar(const uint8_t *hash, const uint8_t *target)
+{
+  return u256::fromLittleEndian(hash) <= u256::fromLittleEndian(target);
+}
+
+#if defined(__AVX2__)
+
+bool passesTargetSIMD(const uint8_t *hash, const uint8_t *target)
+{
+  const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+  const __m256i h = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(hash)), bias);
+  const __m256i t = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(target)), bias);
+
+  const auto gt = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(h, t)));
+  const auto lt = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(t, h)));
+  return gt <= lt;
+}
+
+const char *passesTargetSIMDName()
+{
+  return "avx2";
+}
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+bool passesTargetSIMD(const uint8_t *hash, const uint8_t *target)
+{
+  const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+  const __m128i h0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hash)), bias);
+  const __m128i h1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hash+16)), bias);
+  const __m128i t0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(target)), bias);
+  const __m128i t1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(target+16)), bias);
+
+  const uint32_t gt = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(h0, t0))) |
+                      static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(h1, t1))) << 16;
+  const uint32_t lt = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(t0, h0))) |
+                      static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(t1, h1))) << 16;
+  return gt <= lt;
+}
+
+const char *passesTargetSIMDName()
+{
+  return "sse2";
+}
+
+#elif defined(__ARM_NEON) || defined(__aarch64__)
+
+namespace {
+  // one nibble per byte lane, keeps the byte order of the comparison
+  inline uint64_t nibbleMask(uint8x16_t cmp)
+  {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4)), 0);
+  }
+}
+
+bool passesTargetSIMD(const uint8_t *hash, const uint8_t *target)
+{
+  const uint8x16_t h0 = vld1q_u8(hash);
+  const uint8x16_t h1 = vld1q_u8(hash+16);
+  const uint8x16_t t0 = vld1q_u8(target);
+  const uint8x16_t t1 = vld1q_u8(target+16);
+
+  const uint64_t gt_hi = nibbleMask(vcgtq_u8(h1, t1));
+  const uint64_t lt_hi = nibbleMask(vcltq_u8(h1, t1));
+  if (gt_hi!=lt_hi) {
+    return gt_hi < lt_hi;
+  }
+  return nibbleMask(vcgtq_u8(h0, t0)) <= nibbleMask(vcltq_u8(h0, t0));
+}
+
+const char *passesTargetSIMDName()
+{
+  return "neon";
+}
+
+#else
+
+bool passesTargetSIMD(const uint8_t *hash, const uint8_t *target)
+{
+  return passesTargetScalar(hash, target);
+}
+
+const char *passesTargetSIMDName()
+{
+  return "scalar";
+}
+
+#endif
+
+size_t scanTarget(const uint8_t *hashes, size_t count, const uint8_t *target, uint32_t *indices)
+{
+  size_t found = 0;
+  for (size_t i = 0; i<count; i++) {
+    if (passesTargetSIMD(hashes+i*32, target)) {
+      indices[found++] = static_cast<uint32_t>(i);
+    }
+  }
+  return found;
+}
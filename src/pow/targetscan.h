@@ -0,0 +1,21 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_TARGETSCAN_H
+#define QRANDOMX_TARGETSCAN_H
+
+#include <cstdint>
+#include <cstddef>
+
+// hash <= target for 32-byte little endian values (RandomX output / Monero style targets)
+bool passesTargetScalar(const uint8_t *hash, const uint8_t *target);
+bool passesTargetSIMD(const uint8_t *hash, const uint8_t *target);
+
+// name of the instruction set used by passesTargetSIMD ("avx2", "sse2", "neon" or "scalar")
+const char *passesTargetSIMDName();
+
+// writes the indices of the hashes that pass the target to indices
+// (room for count entries) and returns how many were written
+size_t scanTarget(const uint8_t *hashes, size_t count, const uint8_t *target, uint32_t *indices);
+
+#endif //QRANDOMX_TARGETSCAN_H
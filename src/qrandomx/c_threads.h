@@ -42,6 +42,8 @@
       CloseHandle(p); \
   } WaitForSingleObject(x, INFINITE); } while(0)
 #define CTHR_MUTEX_UNLOCK(x)	ReleaseMutex(x)
+/* false until the first CTHR_MUTEX_LOCK has created the mutex */
+#define CTHR_MUTEX_TRYLOCK(x)	(x != NULL && WaitForSingleObject(x, 0) == WAIT_OBJECT_0)
 #define CTHR_THREAD_TYPE	HANDLE
 #define CTHR_THREAD_RTYPE	void
 #define CTHR_THREAD_RETURN	return
@@ -53,6 +55,7 @@
 #define CTHR_MUTEX_INIT	PTHREAD_MUTEX_INITIALIZER
 #define CTHR_MUTEX_LOCK(x)	pthread_mutex_lock(&x)
 #define CTHR_MUTEX_UNLOCK(x)	pthread_mutex_unlock(&x)
+#define CTHR_MUTEX_TRYLOCK(x)	(pthread_mutex_trylock(&x) == 0)
 #define CTHR_THREAD_TYPE pthread_t
 #define CTHR_THREAD_RTYPE	void *
 #define CTHR_THREAD_RETURN	return NULL
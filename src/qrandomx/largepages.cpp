@@ -0,0 +1,104 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "largepages.h"
+#include "rx-slow-hash.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+  void checkAllocation(RandomXAllocation allocation)
+  {
+    if (allocation<ALLOCATION_CACHE || allocation>ALLOCATION_VM)
+    {
+      throw std::invalid_argument("unknown RandomX allocation");
+    }
+  }
+
+  void checkPolicy(LargePagesPolicy policy)
+  {
+    if (policy<LARGE_PAGES_OFF || policy>LARGE_PAGES_REQUIRE)
+    {
+      throw std::invalid_argument("unknown large pages policy");
+    }
+  }
+}
+
+void LargePages::setPolicy(RandomXAllocation allocation, LargePagesPolicy policy)
+{
+  checkAllocation(allocation);
+  checkPolicy(policy);
+  rx_set_large_pages_policy(allocation, policy);
+}
+
+void LargePages::setPolicy(LargePagesPolicy policy)
+{
+  for (auto allocation: {ALLOCATION_CACHE, ALLOCATION_DATASET, ALLOCATION_VM})
+  {
+    setPolicy(allocation, policy);
+  }
+}
+
+LargePagesPolicy LargePages::policy(RandomXAllocation allocation)
+{
+  checkAllocation(allocation);
+  return static_cast<LargePagesPolicy>(rx_large_pages_policy(allocation));
+}
+
+LargePagesStatus LargePages::status()
+{
+  LargePagesStatus status;
+  status.cache = static_cast<PageBacking>(rx_page_backing(ALLOCATION_CACHE));
+  status.dataset = static_cast<PageBacking>(rx_page_backing(ALLOCATION_DATASET));
+  status.vm = static_cast<PageBacking>(rx_page_backing(ALLOCATION_VM));
+  status.hugePagesTotal = 0;
+  status.hugePagesFree = 0;
+
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+  while (std::getline(meminfo, line))
+  {
+    std::istringstream fields(line);
+    std::string key;
+    uint64_t value = 0;
+    if (fields >> key >> value)
+    {
+      if (key=="HugePages_Total:")
+      {
+        status.hugePagesTotal = value;
+      }
+      else if (key=="HugePages_Free:")
+      {
+        status.hugePagesFree = value;
+      }
+    }
+  }
+
+  // e.g. "always [madvise] never"
+  std::ifstream thp("/sys/kernel/mm/transparent_hugepage/enabled");
+  if (std::getline(thp, line))
+  {
+    const auto begin = line.find('[');
+    const auto end = line.find(']');
+    if (begin!=std::string::npos && end!=std::string::npos && end>begin)
+    {
+      status.transparentHugePages = line.substr(begin+1, end-begin-1);
+    }
+  }
+
+  return status;
+}
+
+void LargePages::preallocate(bool dataset)
+{
+  const auto failed = rx_preallocate(dataset ? 1 : 0);
+  if (failed & (1 << ALLOCATION_CACHE))
+  {
+    throw std::runtime_error("couldn't allocate the RandomX caches under the large pages policy");
+  }
+  if (failed & (1 << ALLOCATION_DATASET))
+  {
+    throw std::runtime_error("couldn't allocate the RandomX dataset under the large pages policy");
+  }
+}
@@ -0,0 +1,58 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_LARGEPAGES_H
+#define QRANDOMX_LARGEPAGES_H
+
+// The enums are shared with rx-slow-hash.c
+enum LargePagesPolicy {
+  LARGE_PAGES_OFF = 0,      // normal pages only
+  LARGE_PAGES_PREFER = 1,   // large pages, else normal pages, which the dataset madvises for transparent huge pages
+  LARGE_PAGES_REQUIRE = 2   // large pages or nothing
+};
+
+enum RandomXAllocation {
+  ALLOCATION_CACHE = 0,
+  ALLOCATION_DATASET = 1,
+  ALLOCATION_VM = 2
+};
+
+enum PageBacking {
+  PAGES_UNALLOCATED = 0,
+  PAGES_LARGE = 1,          // explicit large pages, e.g. from the hugetlb pool
+  PAGES_TRANSPARENT = 2,    // normal pages madvised for transparent huge pages
+  PAGES_NORMAL = 3
+};
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <string>
+
+struct LargePagesStatus {
+  PageBacking cache;        // the seed cache allocated last
+  PageBacking dataset;
+  PageBacking vm;           // the VM created last, by any thread
+  uint64_t hugePagesTotal;  // the hugetlb pool from /proc/meminfo, 0 where unknown
+  uint64_t hugePagesFree;
+  std::string transparentHugePages;   // the kernel THP mode, e.g. "madvise", empty where unknown
+};
+
+// Large pages make RandomX around 30% faster, but every allocation silently falls back to
+// normal pages. Set the policies before the first hash, then check status() or
+// preallocate() at startup to find out whether the fast path is active.
+class LargePages {
+public:
+    static void setPolicy(RandomXAllocation allocation, LargePagesPolicy policy);
+    static void setPolicy(LargePagesPolicy policy);
+    static LargePagesPolicy policy(RandomXAllocation allocation);
+
+    static LargePagesStatus status();
+
+    // Allocates both seed caches and, if dataset is set, the full-memory dataset right away,
+    // while free huge pages are still around. Throws if one of them cannot be allocated under
+    // its policy. A later hash that fails a required allocation aborts the process instead.
+    static void preallocate(bool dataset);
+};
+#endif
+
+#endif //QRANDOMX_LARGEPAGES_H
@@ -36,6 +36,23 @@ uint64_t QRandomX::getSeedHeight(const uint64_t blockNumber) {
   return rx_seedheight(blockNumber);
 }
 
+bool QRandomX::datasetAvailable() {
+  return rx_dataset_available()!=0;
+}
+
+uint32_t QRandomX::fullMemoryVMs() {
+  return static_cast<uint32_t>(rx_full_mem_vm_count());
+}
+
+void QRandomX::releaseDataset() {
+  rx_release_dataset();
+}
+
+bool QRandomX::seedCached(const uint64_t mainHeight,
+        const uint64_t seedHeight, const std::vector<uint8_t>& seedHash) {
+  return rx_seed_cached(mainHeight, seedHeight, (const char *) seedHash.data())!=0;
+}
+
 std::vector<uint8_t> QRandomX::hash(const uint64_t mainHeight,
         const uint64_t seedHeight, const std::vector<uint8_t>& seedHash,
         const std::vector<uint8_t>& input, int miners, int is_alt) {
@@ -49,3 +66,40 @@ std::vector<uint8_t> QRandomX::hash(const uint64_t mainHeight,
   return output;
 }
 
+void QRandomX::hash(const uint64_t mainHeight,
+        const uint64_t seedHeight, const uint8_t *seedHash,
+        const uint8_t *input, size_t input_len,
+        uint8_t *output, int miners, int is_alt) {
+
+  rx_slow_hash(mainHeight, seedHeight, (const char *) seedHash,
+          input, input_len,
+          (char *) output, miners, is_alt);
+}
+
+QRandomXPhaseTimes QRandomX::lastPhaseTimes() {
+  QRandomXPhaseTimes times;
+  rx_last_phase_times(&times.cacheInitNs, &times.datasetInitNs, &times.vmCreateNs);
+  return times;
+}
+
+QRandomXBatch::QRandomXBatch(const uint64_t seedHeight, const std::vector<uint8_t>& seedHash) {
+  rx_batch_lock(seedHeight, (const char *) seedHash.data());
+}
+
+QRandomXBatch::~QRandomXBatch() {
+  rx_batch_unlock();
+}
+
+std::vector<uint8_t> QRandomXBatch::hash(const std::vector<uint8_t>& input) const {
+  std::vector<uint8_t> output(32);
+  rx_batch_hash(input.data(), input.size(), (char *) output.data());
+  return output;
+}
+
+void QRandomXBatch::hash(const uint8_t *input, size_t input_len, uint8_t *output) const {
+  rx_batch_hash(input, input_len, (char *) output);
+}
+
+void QRandomXBatch::freeVM() {
+  rx_batch_free_state();
+}
@@ -30,6 +30,13 @@
 #include <array>
 #include <cstdint>
 
+// Time spent in the setup phases of a hash, all zero on the warm path
+struct QRandomXPhaseTimes {
+  uint64_t cacheInitNs;     // allocating and initializing the cache for a new seed
+  uint64_t datasetInitNs;   // allocating and initializing the full-memory dataset
+  uint64_t vmCreateNs;      // creating the VM, including the large-page fallbacks
+};
+
 class QRandomX {
 public:
     virtual ~QRandomX();
@@ -40,10 +47,50 @@ public:
 
     static uint64_t getSeedHeight(const uint64_t blockNumber);
 
+    // true once the full-memory dataset has been allocated by a hash with miners>0
+    static bool datasetAvailable();
+
+    // VMs hashing against the dataset, by any thread
+    static uint32_t fullMemoryVMs();
+
+    // Frees the dataset once the hashes running on it are done; the full-memory VMs are
+    // recreated at their next hash, which allocates the dataset again if miners>0
+    static void releaseDataset();
+
+    // true if an alt hash for this seed would run on the mainchain cache, i.e. in parallel
+    static bool seedCached(const uint64_t mainHeight,
+            const uint64_t seedHeight, const std::vector<uint8_t>& seedHash);
+
     static std::vector<uint8_t> hash(const uint64_t mainHeight,
             const uint64_t seedHeight, const std::vector<uint8_t>& seedHash,
             const std::vector<uint8_t>& input, int miners, int is_alt = 0);
 
+    // same as above on raw buffers: a 32-byte seedHash, 32 bytes written to output
+    static void hash(const uint64_t mainHeight,
+            const uint64_t seedHeight, const uint8_t *seedHash,
+            const uint8_t *input, size_t input_len,
+            uint8_t *output, int miners, int is_alt = 0);
+
+    // phases of the last hash() made by the calling thread
+    static QRandomXPhaseTimes lastPhaseTimes();
+
+};
+
+// Holds the batch verification cache pinned to one seed for the lifetime of the object.
+// hash() can be called from several threads at once; each of them has to call freeVM()
+// before it exits.
+class QRandomXBatch {
+public:
+    QRandomXBatch(const uint64_t seedHeight, const std::vector<uint8_t>& seedHash);
+    virtual ~QRandomXBatch();
+
+    QRandomXBatch(const QRandomXBatch&) = delete;
+    QRandomXBatch& operator=(const QRandomXBatch&) = delete;
+
+    std::vector<uint8_t> hash(const std::vector<uint8_t>& input) const;
+    void hash(const uint8_t *input, size_t input_len, uint8_t *output) const;
+
+    static void freeVM();
 };
 
 #endif //QRANDOMX_QRANDOMX_H
@@ -22,6 +22,26 @@
   */
 
 #include "qrandomxpool.h"
+#include "misc/metrics.h"
+#include <chrono>
+
+namespace {
+  struct PoolMetrics {
+    MetricGauge &idle = Metrics::instance().gauge(
+            "qrandomx_pool_idle_instances", "QRandomX instances waiting in pools");
+    MetricCounter &created = Metrics::instance().counter(
+            "qrandomx_pool_created_total", "QRandomX instances created because a pool was empty");
+    MetricHistogram &wait = Metrics::instance().histogram(
+            "qrandomx_pool_acquire_seconds", "Time to acquire a QRandomX instance, creation included",
+            {0.000001, 0.00001, 0.0001, 0.001, 0.01, 0.1, 1});
+  };
+
+  PoolMetrics &poolMetrics()
+  {
+    static PoolMetrics metrics;
+    return metrics;
+  }
+}
 
 QRandomXPool::ReturnToPoolDeleter::ReturnToPoolDeleter(std::weak_ptr<QRandomXPool> ptrToOwnerPool)
         : _ptrToOwnerPool(ptrToOwnerPool) { }
@@ -57,6 +77,7 @@ QRandomXPool::QRandomXPool(QRandomXFactory factory)
 QRandomXPool::~QRandomXPool()
 {
   std::unique_lock<std::mutex> lock(_mutex);
+  poolMetrics().idle.add(-static_cast<int64_t>(_poolContainer.size()));
   while (!_poolContainer.empty())
   {
     _poolContainer.top().get_deleter().detachFromPool();
@@ -66,18 +87,25 @@ QRandomXPool::~QRandomXPool()
 
 QRandomXPool::uniqueQRandomXPtr QRandomXPool::acquire()
 {
+  auto &metrics = poolMetrics();
+  const auto start = std::chrono::steady_clock::now();
   std::unique_lock<std::mutex> lock(_mutex);
   if (_poolContainer.empty())
   {
     // no QRandomX instances available in the pool so use the factory to
     // create and return a new one
-    return uniqueQRandomXPtr{_factory(), ReturnToPoolDeleter(shared_from_this())};
+    uniqueQRandomXPtr ptr{_factory(), ReturnToPoolDeleter(shared_from_this())};
+    metrics.created.inc();
+    metrics.wait.observe(std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+    return ptr;
   }
   else
   {
     // grab an unused QRandomX instance from the pool
     auto ptr = std::move(_poolContainer.top());
     _poolContainer.pop();
+    metrics.idle.add(-1);
+    metrics.wait.observe(std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
     return ptr;
   }
 }
@@ -86,6 +114,7 @@ void QRandomXPool::add(QRandomXPool::uniqueQRandomXPtr ptr)
 {
   std::unique_lock<std::mutex> lock(_mutex);
   _poolContainer.push(std::move(ptr));
+  poolMetrics().idle.add(1);
 }
 
 bool QRandomXPool::empty() const
@@ -24,21 +24,39 @@
 #include "qrxminer.h"
 #include "qrandomx.h"
 #include "qrandomxpool.h"
+#include "randomxflags.h"
 #include "pow/powhelper.h"
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <algorithm>
+#include <stdexcept>
 
 #ifndef _WIN32
 #include <netinet/in.h>
 #include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 #else
 #include <winsock.h>
 #endif
 
 #define HASHRATE_MEASUREMENT_CYCLE 100
-#define HASHRATE_MEASUREMENT_FACTOR 10
+#define HASHRATE_MEASUREMENT_MAX_CYCLE 1000
+#define HASHRATE_MEASUREMENT_MIN_HASHES 4    // per thread, keeps throttled rates stable
+#define EVENT_QUEUE_CAPACITY 64
+
+#ifndef _WIN32
+// The event pipe is non-blocking and holds one byte while events are pending,
+// so a write that fails because the pipe is full needs no handling
+static void signalFd(int fd)
+{
+  const uint8_t signal = 1;
+  ssize_t written = write(fd, &signal, 1);
+  (void) written;
+}
+#endif
 
 class ScopedCounter {
 public:
@@ -55,14 +73,47 @@ public:
     std::atomic<std::uint32_t>& _counter;
 };
 
+// Per-thread pacing for the hashrate limit (token bucket holding a single
+// token) and the duty cycle (idle time proportional to the time spent hashing)
+class HashPacer {
+public:
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point next(clock::time_point hashStart, clock::time_point hashEnd,
+                           uint32_t hashrateLimit, uint32_t dutyCycle, uint32_t threadCount)
+    {
+      auto resume = hashEnd;
+
+      if (hashrateLimit>0) {
+        const auto period = std::chrono::duration_cast<clock::duration>(
+                std::chrono::duration<double>(double(threadCount)/hashrateLimit));
+        _nextSlot = std::max(_nextSlot+period, hashEnd-period);
+        resume = std::max(resume, _nextSlot);
+      }
+
+      if (dutyCycle<100) {
+        _idleDebt += (hashEnd-hashStart)*(100-dutyCycle)/dutyCycle;
+        if (_idleDebt>=std::chrono::milliseconds(1)) {
+          resume = std::max(resume, hashEnd+_idleDebt);
+          _idleDebt = clock::duration::zero();
+        }
+      }
+
+      return resume;
+    }
+
+private:
+    clock::time_point _nextSlot{clock::now()};
+    clock::duration _idleDebt{clock::duration::zero()};
+};
+
 std::shared_ptr<QRandomXPool> QRXMiner::_qrxpool = std::make_shared<QRandomXPool>();
 
 QRXMiner::QRXMiner()
 {
-  _eventThread = std::make_unique<std::thread>([&]() { _eventThreadWorker(); });
-  _referenceTime = std::chrono::high_resolution_clock::now();
-  _deadline_enabled = false;
   _pause_milliseconds = 0;
+  _eventThread = std::make_unique<std::thread>([&]() { _eventThreadWorker(); });
+  _timerThread = std::make_unique<std::thread>([&]() { _timerThreadWorker(); });
 }
 
 QRXMiner::~QRXMiner()
@@ -74,37 +125,76 @@ QRXMiner::~QRXMiner()
     _eventReleased.notify_one();
   }
   _eventThread->join();
+  {
+    std::lock_guard<std::mutex> timer_lock(_timer_mutex);
+    _stop_timerThread = true;
+    _timerReleased.notify_one();
+  }
+  _timerThread->join();
+
+#ifndef _WIN32
+  for (auto fd: _event_pipe) {
+    if (fd>=0) {
+      close(fd);
+    }
+  }
+#endif
 }
 
 bool QRXMiner::solutionAvailable()
 {
-  std::lock_guard<std::recursive_timed_mutex> lock(_solution_mutex);
+  std::lock_guard<std::mutex> lock(_solution_mutex);
   return _solution_found;
 }
 
 bool QRXMiner::waitForAnswer(uint32_t timeoutSeconds)
 {
-  for (int i=0; i<timeoutSeconds; i++)
-  {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    if (solutionAvailable())
-    {
-      return true;
+  return _waitFor(std::chrono::seconds(timeoutSeconds))==WAIT_SOLUTION;
+}
+
+MinerWaitResult QRXMiner::waitForEvent(uint32_t timeoutMilliseconds)
+{
+  return _waitFor(std::chrono::milliseconds(timeoutMilliseconds));
+}
+
+MinerWaitResult QRXMiner::_waitFor(std::chrono::milliseconds timeout)
+{
+  const uint64_t sequence_id = _work_sequence_id;
+  MinerWaitResult result = WAIT_TIMEOUT;
+
+  std::unique_lock<std::mutex> lock(_wait_mutex);
+  _waitReleased.wait_for(lock, timeout, [&] {
+    if (_solution_found) {
+      result = WAIT_SOLUTION;
     }
-  }
-  return false;
+    else if (_deadline_reached) {
+      result = WAIT_DEADLINE;
+    }
+    else if (_stop_request || _work_sequence_id!=sequence_id) {
+      result = WAIT_CANCELLED;
+    }
+    return result!=WAIT_TIMEOUT;
+  });
+
+  return result;
+}
+
+void QRXMiner::_notifyWaiters()
+{
+  std::lock_guard<std::mutex> lock(_wait_mutex);
+  _waitReleased.notify_all();
 }
 
 
 std::vector<uint8_t> QRXMiner::solutionInput()
 {
-  std::lock_guard<std::recursive_timed_mutex> lock(_solution_mutex);
+  std::lock_guard<std::mutex> lock(_solution_mutex);
   return _solution_input;
 }
 
 uint32_t QRXMiner::solutionNonce()
 {
-  std::lock_guard<std::recursive_timed_mutex> lock(_solution_mutex);
+  std::lock_guard<std::mutex> lock(_solution_mutex);
   auto p = _solution_input.data();
   auto nonce = reinterpret_cast<uint32_t*>(p+_nonceOffset);
   return ntohl(*nonce);
@@ -112,7 +202,7 @@ uint32_t QRXMiner::solutionNonce()
 
 std::vector<uint8_t> QRXMiner::solutionHash()
 {
-  std::lock_guard<std::recursive_timed_mutex> lock(_solution_mutex);
+  std::lock_guard<std::mutex> lock(_solution_mutex);
   return _solution_hash;
 }
 
@@ -121,28 +211,66 @@ uint32_t QRXMiner::hashRate()
   return static_cast<uint32_t>(_hash_per_sec);
 };
 
+std::int64_t QRXMiner::_steadyMilliseconds()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
 void QRXMiner::disableTimer()
 {
+  std::lock_guard<std::mutex> timer_lock(_timer_mutex);
   _deadline_enabled = false;
+  _timerReleased.notify_one();
 }
 
 void QRXMiner::setTimer(uint32_t stopInMilliseconds)
 {
-  auto now = std::chrono::high_resolution_clock::now();
-  auto current_offset = std::chrono::duration_cast<std::chrono::milliseconds>(now-_referenceTime);
-
-  _deadline_milliseconds = current_offset.count()+stopInMilliseconds;
+  std::lock_guard<std::mutex> timer_lock(_timer_mutex);
+  _deadline_milliseconds = _steadyMilliseconds()+stopInMilliseconds;
+  _deadline_sequence_id = _work_sequence_id.load();
   _deadline_enabled = true;
+  _timerReleased.notify_one();
 }
 
 uint32_t QRXMiner::getSecondsRemaining()
 {
-  auto now = std::chrono::high_resolution_clock::now();
-  auto current_offset = std::chrono::duration_cast<std::chrono::milliseconds>(now-_referenceTime);
-  auto remaining = _deadline_milliseconds.load()-current_offset.count();
+  auto remaining = _deadline_milliseconds.load()-_steadyMilliseconds();
   if (remaining<=0)
     return 0;
-  return (uint32_t) remaining;
+  return static_cast<uint32_t>(std::min<std::int64_t>(remaining, UINT32_MAX));
+}
+
+void QRXMiner::_timerThreadWorker()
+{
+  std::unique_lock<std::mutex> timer_lock(_timer_mutex);
+  while (!_stop_timerThread) {
+    if (!_deadline_enabled) {
+      _timerReleased.wait(timer_lock);
+      continue;
+    }
+
+    // setTimer/disableTimer/cancel notify, so simply re-evaluate on wake up
+    const auto deadline = std::chrono::steady_clock::time_point(
+            std::chrono::milliseconds(_deadline_milliseconds.load()));
+    if (_timerReleased.wait_until(timer_lock, deadline)==std::cv_status::no_timeout) {
+      continue;
+    }
+    if (!_deadline_enabled || getSecondsRemaining()>0) {
+      continue;
+    }
+
+    // cancel() needs this lock to disarm the timer, so the job cannot be
+    // replaced between this check and the stop request
+    _deadline_enabled = false;
+    const uint64_t sequence_id = _deadline_sequence_id;
+    if (sequence_id==_work_sequence_id && !_stop_request && !_solution_found) {
+      _queueEvent({TIMEOUT, sequence_id, 0});
+      _deadline_reached = true;
+      _stop_request = true;
+      _notifyWaiters();
+    }
+  }
 }
 
 void QRXMiner::setForcedSleep(uint32_t pauseInMilliseconds)
@@ -150,6 +278,53 @@ void QRXMiner::setForcedSleep(uint32_t pauseInMilliseconds)
   _pause_milliseconds = pauseInMilliseconds;
 }
 
+void QRXMiner::setHashRateLimit(uint32_t hashesPerSecond)
+{
+  _hashrate_limit = hashesPerSecond;
+}
+
+void QRXMiner::setDutyCycle(uint32_t percent)
+{
+  if (percent==0 || percent>100)
+  {
+    throw std::invalid_argument("duty cycle should be between 1 and 100");
+  }
+  _duty_cycle = percent;
+}
+
+void QRXMiner::setFastMode(bool enabled)
+{
+  _fast_mode = enabled;
+  if (!enabled)
+  {
+    QRandomX::releaseDataset();
+  }
+}
+
+bool QRXMiner::fastModeActive()
+{
+  return _fast_mode && QRandomX::fullMemoryVMs()>0 &&
+         !(RandomXFlags::get().masked & FLAG_FULL_MEM);
+}
+
+void QRXMiner::_pauseUntil(std::chrono::steady_clock::time_point until)
+{
+  // solution, deadline and cancel notify waiters, so a paused thread stops promptly
+  std::unique_lock<std::mutex> lock(_wait_mutex);
+  _waitReleased.wait_until(lock, until, [&] { return _stop_request || _solution_found; });
+}
+
+void QRXMiner::setEventBackoff(uint32_t initialMilliseconds, uint32_t maxMilliseconds)
+{
+  if (initialMilliseconds==0)
+    initialMilliseconds = 1;
+  if (maxMilliseconds<initialMilliseconds)
+    maxMilliseconds = initialMilliseconds;
+
+  _event_backoff_initial = initialMilliseconds;
+  _event_backoff_max = maxMilliseconds;
+}
+
 uint64_t QRXMiner::start(uint64_t mainHeight,
                          uint64_t seedHeight,
                          const std::vector<uint8_t>& seedHash,
@@ -168,20 +343,21 @@ uint64_t QRXMiner::start(uint64_t mainHeight,
   _target = target;
 
   _stop_request = false;
+  _deadline_reached = false;
   _solution_found = false;
   _hash_count = 0;
   _hash_per_sec = 0;
 
   uint64_t current_work_sequence_id = _work_sequence_id.load();
 
-  std::lock_guard<std::recursive_timed_mutex> lock_runningThreads(_runningThreads_mutex);
+  std::lock_guard<std::mutex> lock_runningThreads(_runningThreads_mutex);
 
   if (thread_count==0) {
     thread_count = std::thread::hardware_concurrency();
   }
 
   for (uint32_t thread_idx = 0; thread_idx<thread_count; thread_idx++) {
-    _runningThreads.emplace_back(std::make_unique<std::thread>([&](uint32_t thread_idx, uint8_t thread_count, uint64_t current_work_sequence_id) {
+    _runningThreads.emplace_back(std::make_unique<std::thread>([&](uint32_t thread_idx, uint32_t thread_count, uint64_t current_work_sequence_id) {
       ScopedCounter thread_counter(_runningThreads_count);
 
       auto qrx = _qrxpool->acquire();
@@ -191,47 +367,54 @@ uint64_t QRXMiner::start(uint64_t mainHeight,
 
       uint32_t current_nonce = thread_idx;
 
-      auto hashrateReferenceTime = std::chrono::high_resolution_clock::now();
-      std::chrono::high_resolution_clock::time_point threadTime;
-      double drift = 0;
+      auto hashrateReferenceTime = std::chrono::steady_clock::now();
+      HashPacer pacer;
 
       while (!_stop_request && !_solution_found) {
         *nonce = htonl(current_nonce);
-        auto current_hash = qrx->hash(_mainHeight, _seedHeight, _seedHash, tmp_input, 0);
+        // in fast mode the first hash allocates the dataset, all threads share its initialization
+        const int miners = _fast_mode ? static_cast<int>(thread_count) : 0;
+        auto hashStart = std::chrono::steady_clock::now();
+        auto current_hash = qrx->hash(_mainHeight, _seedHeight, _seedHash, tmp_input, miners);
+        auto hashEnd = std::chrono::steady_clock::now();
         _hash_count++;
 
         if (thread_idx==0) {
-          threadTime = std::chrono::high_resolution_clock::now();
-          std::chrono::duration<double, std::milli> delta = threadTime-hashrateReferenceTime;
-          if (delta.count()+drift>HASHRATE_MEASUREMENT_CYCLE) {
-            drift = delta.count()+drift-HASHRATE_MEASUREMENT_CYCLE;
-            hashrateReferenceTime = std::chrono::high_resolution_clock::now();
-            _hash_per_sec = _hash_count*HASHRATE_MEASUREMENT_FACTOR;
-            _hash_count = 0;
-          }
-
-          if (_deadline_enabled && getSecondsRemaining()==0) {
-            _queueEvent({TIMEOUT, current_work_sequence_id});
-            _stop_request = true;
-            break;
+          // use the real elapsed time so pauses do not skew the measurement
+          std::chrono::duration<double, std::milli> delta = hashEnd-hashrateReferenceTime;
+          if (delta.count()>=HASHRATE_MEASUREMENT_MAX_CYCLE ||
+              (delta.count()>=HASHRATE_MEASUREMENT_CYCLE &&
+               _hash_count>=thread_count*HASHRATE_MEASUREMENT_MIN_HASHES)) {
+            hashrateReferenceTime = hashEnd;
+            _hash_per_sec = static_cast<uint32_t>(_hash_count.exchange(0)*1000.0/delta.count());
           }
         }
 
-        if (_pause_milliseconds>0)
-        {
-          std::this_thread::sleep_for(std::chrono::milliseconds(_pause_milliseconds));
-        }
-
         if (PoWHelper::passesTarget(current_hash, _target)) {
-          std::lock_guard<std::recursive_timed_mutex> lock_solution(_solution_mutex);
+          std::lock_guard<std::mutex> lock_solution(_solution_mutex);
           if (!_solution_found) {
             _solution_found = true;
             _solution_input = tmp_input;
             _solution_hash = current_hash;
             _queueEvent({SOLUTION, current_work_sequence_id, current_nonce});
+            _notifyWaiters();
           }
         }
 
+        // report a solution first, the pause can last a whole pacing slot
+        if (_solution_found) {
+          break;
+        }
+        auto resume = pacer.next(hashStart, hashEnd, _hashrate_limit, _duty_cycle, thread_count);
+        if (_pause_milliseconds>0)
+        {
+          resume = std::max(resume, hashEnd+std::chrono::milliseconds(_pause_milliseconds));
+        }
+        if (resume>hashEnd)
+        {
+          _pauseUntil(resume);
+        }
+
         current_nonce += thread_count;
       }
       qrx->freeVM();
@@ -241,24 +424,104 @@ uint64_t QRXMiner::start(uint64_t mainHeight,
   return _work_sequence_id;
 }
 
-void QRXMiner::_queueEvent(MinerEvent event)
+bool QRXMiner::_queueEvent(MinerEvent event)
 {
+  // Called from the mining threads, so this must never block on the consumer
   std::lock_guard<std::mutex> lock_queue(_eventQueue_mutex);
+  if (_eventQueue.size()>=EVENT_QUEUE_CAPACITY) {
+    // make room by dropping events that belong to a previous job
+    for (auto it = _eventQueue.begin(); it!=_eventQueue.end();) {
+      it = _isStale(*it) ? _eventQueue.erase(it) : it+1;
+    }
+    if (_eventQueue.size()>=EVENT_QUEUE_CAPACITY) {
+      return false;
+    }
+  }
   _eventQueue.push_back(event);
+#ifndef _WIN32
+  if (_event_polling && _eventQueue.size()==1 && _event_pipe[1]>=0) {
+    signalFd(_event_pipe[1]);
+  }
+#endif
+  _eventReleased.notify_one();
+  return true;
+}
+
+void QRXMiner::setEventPolling(bool enabled)
+{
+  std::lock_guard<std::mutex> queue_lock(_eventQueue_mutex);
+#ifndef _WIN32
+  if (enabled && _event_pipe[0]<0) {
+    if (pipe(_event_pipe)!=0) {
+      throw std::runtime_error("cannot create the event pipe");
+    }
+    for (auto fd: _event_pipe) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    if (!_eventQueue.empty()) {
+      signalFd(_event_pipe[1]);
+    }
+  }
+#endif
+  _event_polling = enabled;
+  // events queued so far go to the newly selected consumer
   _eventReleased.notify_one();
 }
 
+int QRXMiner::eventFd()
+{
+  return _event_polling ? _event_pipe[0] : -1;
+}
+
+std::vector<MinerEvent> QRXMiner::pollEvents()
+{
+  std::vector<MinerEvent> events;
+  std::lock_guard<std::mutex> queue_lock(_eventQueue_mutex);
+  if (!_event_polling) {
+    return events;
+  }
+
+  for (const auto& event: _eventQueue) {
+    if (!_isStale(event)) {
+      events.push_back(event);
+    }
+  }
+  _eventQueue.clear();
+
+#ifndef _WIN32
+  uint8_t signal;
+  while (read(_event_pipe[0], &signal, 1)>0) {}
+#endif
+  return events;
+}
+
+bool QRXMiner::_isStale(const MinerEvent& event)
+{
+  return event.seq!=_work_sequence_id;
+}
+
 void QRXMiner::cancel()
 {
-  std::lock_guard<std::recursive_timed_mutex> lock1(_event_mutex);
-  std::lock_guard<std::recursive_timed_mutex> lock2(_runningThreads_mutex);
-  _stop_request = true;
+  std::lock_guard<std::mutex> lock(_runningThreads_mutex);
+  {
+    std::lock_guard<std::mutex> timer_lock(_timer_mutex);
+    _deadline_enabled = false;
+    _stop_request = true;
+    _timerReleased.notify_one();
+  }
+  _notifyWaiters();
 
   for (auto& t : _runningThreads) {
     t->join();
   }
   _runningThreads.clear();
   _work_sequence_id++;
+  _notifyWaiters();
+
+  // wake up the event thread so it can drop any event waiting for a retry
+  std::lock_guard<std::mutex> queue_lock(_eventQueue_mutex);
+  _eventReleased.notify_one();
 }
 
 bool QRXMiner::isRunning()
@@ -273,9 +536,7 @@ std::uint32_t QRXMiner::runningThreadCount()
 
 uint8_t QRXMiner::_sendEvent(MinerEvent event)
 {
-  std::lock_guard<std::recursive_timed_mutex> lock(_event_mutex);
-
-  if (event.seq!=_work_sequence_id)
+  if (_isStale(event))
     return 1;    // handled
 
   try {
@@ -289,27 +550,32 @@ uint8_t QRXMiner::_sendEvent(MinerEvent event)
 
 void QRXMiner::_eventThreadWorker()
 {
+  std::unique_lock<std::mutex> queue_lock(_eventQueue_mutex);
   while (!_stop_eventThread) {
-    std::unique_lock<std::mutex> queue_lock(_eventQueue_mutex);
     _eventReleased.wait(queue_lock,
-                        [=] { return !_eventQueue.empty() || _stop_eventThread; });
+                        [=] { return (!_eventQueue.empty() && !_event_polling) || _stop_eventThread; });
+    if (_stop_eventThread) {
+      break;
+    }
 
-    if (!_eventQueue.empty()) {
-      auto event = _eventQueue.front();
-      _eventQueue.pop_front();
+    auto event = _eventQueue.front();
+    _eventQueue.pop_front();
+
+    uint32_t backoff = _event_backoff_initial;
+    while (!_stop_eventThread && !_isStale(event)) {
       queue_lock.unlock();
+      const bool handled = _sendEvent(event)!=0;
+      queue_lock.lock();
 
-      if (event.seq==_work_sequence_id) {
-        if (!_sendEvent(event))
-        {
-          // if event was not processed, put back in the queue and idle for 100ms
-          _queueEvent(event);
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+      if (handled) {
+        break;
       }
-    }
-    else {
-      queue_lock.unlock();
+
+      // not accepted yet, retry later unless the job is cancelled meanwhile
+      _eventReleased.wait_for(queue_lock,
+                              std::chrono::milliseconds(backoff),
+                              [&] { return _stop_eventThread || _isStale(event); });
+      backoff = std::min<uint32_t>(backoff*2, _event_backoff_max);
     }
   }
 }
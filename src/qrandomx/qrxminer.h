@@ -38,6 +38,13 @@ enum MinerEventType {
   TIMEOUT = 1
 };
 
+enum MinerWaitResult {
+  WAIT_SOLUTION = 0,    // a solution is available
+  WAIT_DEADLINE = 1,    // the job was stopped by the timer set with setTimer()
+  WAIT_CANCELLED = 2,   // the job was cancelled or replaced
+  WAIT_TIMEOUT = 3      // nothing happened before the wait timed out
+};
+
 struct MinerEvent {
   MinerEventType type;
   uint64_t seq;
@@ -59,13 +66,41 @@ public:
 
   uint64_t currentSequenceId() { return _work_sequence_id.load(); }
 
+  // the timer belongs to the current job: starting a new job or cancelling
+  // the current one disarms it
   void setTimer(uint32_t stopInMilliseconds);
   void disableTimer();
   uint32_t getSecondsRemaining();
 
   void setForcedSleep(uint32_t pauseInMilliseconds);
 
+  // throttling: cap the total hashrate of the job (0 disables the cap) and/or
+  // the fraction of time each mining thread spends hashing (1-100%)
+  void setHashRateLimit(uint32_t hashesPerSecond);
+  void setDutyCycle(uint32_t percent);
+
+  // fast mode mines against the full-memory dataset (over 2 GB, allocated once
+  // and initialized by all mining threads). If the dataset cannot be allocated or
+  // FLAG_FULL_MEM is masked the miner keeps hashing in light mode; fastModeActive()
+  // tells which is used. Disabling it releases the dataset, the mining threads
+  // switch to light mode at their next hash
+  void setFastMode(bool enabled);
+  bool fastModeActive();
+
+  // retry policy for events that handleEvent() did not accept (returned 0)
+  // the delay doubles on each attempt, starting at initial and capped at max
+  void setEventBackoff(uint32_t initialMilliseconds, uint32_t maxMilliseconds);
+
+  // Polling mode delivers events without calling handleEvent(): they queue up until
+  // pollEvents() takes them, and the descriptor returned by eventFd() is readable while any
+  // are pending (e.g. for asyncio's loop.add_reader). Events of a previous job are dropped.
+  // eventFd() returns -1 when polling is off or the platform has no pipes.
+  void setEventPolling(bool enabled);
+  int eventFd();
+  std::vector<MinerEvent> pollEvents();
+
   bool waitForAnswer(uint32_t timeoutSeconds);
+  MinerWaitResult waitForEvent(uint32_t timeoutMilliseconds);
 
   void cancel();
   bool isRunning();
@@ -81,10 +116,19 @@ public:
 
 protected:
   uint8_t _sendEvent(MinerEvent event);
-  void _queueEvent(MinerEvent event);
+  bool _queueEvent(MinerEvent event);
+  bool _isStale(const MinerEvent& event);
 
   void _eventThreadWorker();
 
+  void _timerThreadWorker();
+  static std::int64_t _steadyMilliseconds();
+
+  void _pauseUntil(std::chrono::steady_clock::time_point until);
+
+  MinerWaitResult _waitFor(std::chrono::milliseconds timeout);
+  void _notifyWaiters();
+
   uint64_t _mainHeight;
   uint64_t _seedHeight;
   std::vector<uint8_t> _seedHash;
@@ -100,30 +144,51 @@ protected:
   std::atomic_bool _solution_found{false};
   std::atomic_bool _stop_eventThread{false};
   std::atomic_bool _stop_request{false};
+  std::atomic_bool _deadline_reached{false};
 
   std::atomic<std::uint32_t> _hash_count{0};
   std::atomic<std::uint32_t> _hash_per_sec{0};
 
-  std::atomic<std::int32_t> _deadline_milliseconds;
-  std::atomic<bool> _deadline_enabled;
+  // deadline in milliseconds of the monotonic (steady) clock
+  std::atomic<std::int64_t> _deadline_milliseconds{0};
+  std::atomic<std::uint64_t> _deadline_sequence_id{0};
+  std::atomic<bool> _deadline_enabled{false};
 
   std::atomic<std::int32_t> _pause_milliseconds;
+  std::atomic<std::uint32_t> _hashrate_limit{0};
+  std::atomic<std::uint32_t> _duty_cycle{100};
+  std::atomic_bool _fast_mode{false};
+
+  std::atomic<std::uint32_t> _event_backoff_initial{1};
+  std::atomic<std::uint32_t> _event_backoff_max{100};
 
   std::vector<std::unique_ptr<std::thread>> _runningThreads;
   std::atomic<std::uint32_t> _runningThreads_count{0};
 
-  std::recursive_timed_mutex _solution_mutex;
-  std::recursive_timed_mutex _event_mutex;
-  std::recursive_timed_mutex _runningThreads_mutex;
+  std::mutex _solution_mutex;
+  std::mutex _runningThreads_mutex;
 
   std::future<void> _solution_event;
   std::unique_ptr<std::thread> _eventThread;
 
+  // bounded, multi-producer (mining threads) / single-consumer (event thread)
+  // the mutex is only held to push/pop, never while handleEvent() runs
   std::deque<MinerEvent> _eventQueue;
   std::mutex _eventQueue_mutex;
   std::condition_variable _eventReleased;
 
-  std::chrono::high_resolution_clock::time_point _referenceTime;
+  // in polling mode the event thread leaves _eventQueue alone; the pipe is readable
+  // while the queue is not empty
+  std::atomic_bool _event_polling{false};
+  int _event_pipe[2]{-1, -1};
+
+  std::mutex _wait_mutex;
+  std::condition_variable _waitReleased;
+
+  std::unique_ptr<std::thread> _timerThread;
+  std::atomic_bool _stop_timerThread{false};
+  std::mutex _timer_mutex;
+  std::condition_variable _timerReleased;
 
   static std::shared_ptr<QRandomXPool> _qrxpool;
 };
@@ -0,0 +1,85 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "randomxflags.h"
+#include "rx-slow-hash.h"
+#include "RandomX/src/randomx.h"
+#include <stdexcept>
+#include <utility>
+
+static_assert(int(FLAG_LARGE_PAGES)==int(RANDOMX_FLAG_LARGE_PAGES) && int(FLAG_HARD_AES)==int(RANDOMX_FLAG_HARD_AES) &&
+              int(FLAG_FULL_MEM)==int(RANDOMX_FLAG_FULL_MEM) && int(FLAG_JIT)==int(RANDOMX_FLAG_JIT) &&
+              int(FLAG_SECURE)==int(RANDOMX_FLAG_SECURE) && int(FLAG_ARGON2_SSSE3)==int(RANDOMX_FLAG_ARGON2_SSSE3) &&
+              int(FLAG_ARGON2_AVX2)==int(RANDOMX_FLAG_ARGON2_AVX2), "RandomXFlag has to match randomx_flags");
+
+namespace {
+  const uint32_t KNOWN_FLAGS = FLAG_LARGE_PAGES | FLAG_HARD_AES | FLAG_FULL_MEM | FLAG_JIT |
+                               FLAG_SECURE | FLAG_ARGON2_SSSE3 | FLAG_ARGON2_AVX2;
+}
+
+RandomXFlagsInfo RandomXFlags::get()
+{
+  int detected, forced, masked, last_vm;
+  rx_get_flags(&detected, &forced, &masked, &last_vm);
+
+  RandomXFlagsInfo info;
+  info.detected = static_cast<uint32_t>(detected);
+  info.forced = static_cast<uint32_t>(forced);
+  info.masked = static_cast<uint32_t>(masked);
+  info.effective = (info.detected | info.forced) & ~info.masked;
+  info.lastVm = static_cast<uint32_t>(last_vm);
+  return info;
+}
+
+void RandomXFlags::setOverride(uint32_t forced, uint32_t masked)
+{
+  if ((forced | masked) & ~KNOWN_FLAGS)
+  {
+    throw std::invalid_argument("unknown RandomX flags");
+  }
+  if ((forced | masked) & FLAG_LARGE_PAGES)
+  {
+    throw std::invalid_argument("large pages are set through LargePages");
+  }
+  if (forced & FLAG_FULL_MEM)
+  {
+    throw std::invalid_argument("full memory mode can only be masked");
+  }
+  if (forced & masked)
+  {
+    throw std::invalid_argument("a flag cannot be forced and masked at once");
+  }
+  rx_set_flags_override(static_cast<int>(forced), static_cast<int>(masked));
+}
+
+void RandomXFlags::resetOverride()
+{
+  rx_reset_flags_override();
+}
+
+std::string RandomXFlags::describe(uint32_t flags)
+{
+  static const std::pair<uint32_t, const char *> names[] = {
+          {FLAG_LARGE_PAGES, "large_pages"},
+          {FLAG_HARD_AES, "hard_aes"},
+          {FLAG_FULL_MEM, "full_mem"},
+          {FLAG_JIT, "jit"},
+          {FLAG_SECURE, "secure"},
+          {FLAG_ARGON2_SSSE3, "argon2_ssse3"},
+          {FLAG_ARGON2_AVX2, "argon2_avx2"},
+  };
+
+  std::string out;
+  for (const auto &name: names)
+  {
+    if (flags & name.first)
+    {
+      if (!out.empty())
+      {
+        out += " ";
+      }
+      out += name.second;
+    }
+  }
+  return out;
+}
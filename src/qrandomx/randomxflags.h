@@ -0,0 +1,51 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_RANDOMXFLAGS_H
+#define QRANDOMX_RANDOMXFLAGS_H
+
+#include <cstdint>
+#include <string>
+
+// same bits as randomx_flags
+enum RandomXFlag {
+  FLAG_LARGE_PAGES = 1,
+  FLAG_HARD_AES = 2,
+  FLAG_FULL_MEM = 4,
+  FLAG_JIT = 8,
+  FLAG_SECURE = 16,
+  FLAG_ARGON2_SSSE3 = 32,
+  FLAG_ARGON2_AVX2 = 64
+};
+
+struct RandomXFlagsInfo {
+  uint32_t detected;    // what randomx_get_flags() found on this CPU
+  uint32_t forced;      // used even if not detected
+  uint32_t masked;      // never used
+  uint32_t effective;   // (detected | forced) & ~masked, what new caches and VMs start from
+  uint32_t lastVm;      // the flags of the VM created last, by any thread, 0 before the first
+};
+
+// The flags used to be fixed at the first hash from randomx_get_flags() and the
+// MONERO_RANDOMX_UMASK environment variable, which remains the initial mask. An override
+// replaces both the forced and the masked flags and applies process-wide: every thread
+// recreates its VM at its next hash, e.g. to compare the interpreter with the JIT or soft
+// with hard AES in one process. Cache flags (the Argon2 implementations, JIT dataset
+// initialization) only change the setup speed, not the hashes; the batch cache follows at
+// the next batch while the mainchain caches keep theirs, as other threads may hash with them.
+class RandomXFlags {
+public:
+    static RandomXFlagsInfo get();
+
+    // Forcing a flag the CPU lacks (e.g. FLAG_HARD_AES) crashes the next hash. Large pages
+    // are set through LargePages, and FLAG_FULL_MEM can only be masked, keeping miners light.
+    static void setOverride(uint32_t forced, uint32_t masked);
+
+    // back to the detected flags and MONERO_RANDOMX_UMASK
+    static void resetOverride();
+
+    // e.g. "hard_aes jit secure"
+    static std::string describe(uint32_t flags);
+};
+
+#endif //QRANDOMX_RANDOMXFLAGS_H
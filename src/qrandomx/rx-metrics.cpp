@@ -0,0 +1,74 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rx-metrics.h"
+#include "misc/metrics.h"
+#include <array>
+
+namespace {
+  struct RxMetrics {
+    std::array<MetricCounter*, RX_COUNTERS> counters;
+    std::array<MetricHistogram*, RX_TIMERS> timers;
+
+    RxMetrics()
+    {
+      auto &m = Metrics::instance();
+      counters[RX_COUNTER_HASHES] = &m.counter(
+              "qrandomx_hashes_total", "RandomX hashes computed", "path=\"slow_hash\"");
+      counters[RX_COUNTER_BATCH_HASHES] = &m.counter(
+              "qrandomx_hashes_total", "RandomX hashes computed", "path=\"batch\"");
+      counters[RX_COUNTER_SEED_CACHE_HITS] = &m.counter(
+              "qrandomx_seed_cache_hits_total", "Hashes whose seed was already in the cache slot");
+      counters[RX_COUNTER_SEED_CACHE_MISSES] = &m.counter(
+              "qrandomx_seed_cache_misses_total", "Hashes that had to rebuild the cache for their seed");
+      counters[RX_COUNTER_DATASET_REBUILDS] = &m.counter(
+              "qrandomx_dataset_rebuilds_total", "Full-memory dataset initializations");
+      counters[RX_COUNTER_VM_CREATIONS] = &m.counter(
+              "qrandomx_vm_creations_total", "RandomX VMs created");
+      counters[RX_COUNTER_ALT_CONTENDED] = &m.counter(
+              "qrandomx_alt_slot_contended_total", "Alt-chain hashes that waited for the alt cache slot");
+
+      const char *large_pages = "qrandomx_large_page_allocations_total";
+      const char *large_pages_help = "Allocations attempted with large pages, by outcome";
+      counters[RX_COUNTER_LARGE_PAGES_CACHE_OK] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"cache\",result=\"ok\"");
+      counters[RX_COUNTER_LARGE_PAGES_CACHE_FAILED] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"cache\",result=\"failed\"");
+      counters[RX_COUNTER_LARGE_PAGES_DATASET_OK] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"dataset\",result=\"ok\"");
+      counters[RX_COUNTER_LARGE_PAGES_DATASET_FAILED] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"dataset\",result=\"failed\"");
+      counters[RX_COUNTER_LARGE_PAGES_VM_OK] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"vm\",result=\"ok\"");
+      counters[RX_COUNTER_LARGE_PAGES_VM_FAILED] = &m.counter(
+              large_pages, large_pages_help, "allocation=\"vm\",result=\"failed\"");
+
+      timers[RX_TIMER_HASH] = &m.histogram(
+              "qrandomx_hash_duration_seconds", "rx_slow_hash latency including any cache, dataset or VM setup");
+      timers[RX_TIMER_CACHE_REBUILD] = &m.histogram(
+              "qrandomx_cache_rebuild_duration_seconds", "Cache allocation and initialization for a new seed");
+      timers[RX_TIMER_DATASET_REBUILD] = &m.histogram(
+              "qrandomx_dataset_rebuild_duration_seconds", "Dataset allocation and initialization");
+      timers[RX_TIMER_VM_CREATE] = &m.histogram(
+              "qrandomx_vm_create_duration_seconds", "VM creation including large-page fallbacks");
+      timers[RX_TIMER_ALT_WAIT] = &m.histogram(
+              "qrandomx_alt_slot_wait_seconds", "Time alt-chain hashes waited for the alt cache slot");
+    }
+  };
+
+  RxMetrics &rxMetrics()
+  {
+    static RxMetrics metrics;
+    return metrics;
+  }
+}
+
+void rx_metric_inc(enum rx_counter counter)
+{
+  rxMetrics().counters[counter]->inc();
+}
+
+void rx_metric_observe_ns(enum rx_timer timer, uint64_t ns)
+{
+  rxMetrics().timers[timer]->observe(ns/1e9);
+}
@@ -0,0 +1,48 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef QRANDOMX_RX_METRICS_H
+#define QRANDOMX_RX_METRICS_H
+
+#include <stdint.h>
+
+/* Metrics updated from rx-slow-hash.c, registered in misc/metrics.h */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+enum rx_counter {
+  RX_COUNTER_HASHES,
+  RX_COUNTER_BATCH_HASHES,
+  RX_COUNTER_SEED_CACHE_HITS,
+  RX_COUNTER_SEED_CACHE_MISSES,
+  RX_COUNTER_DATASET_REBUILDS,
+  RX_COUNTER_VM_CREATIONS,
+  RX_COUNTER_ALT_CONTENDED,
+  RX_COUNTER_LARGE_PAGES_CACHE_OK,
+  RX_COUNTER_LARGE_PAGES_CACHE_FAILED,
+  RX_COUNTER_LARGE_PAGES_DATASET_OK,
+  RX_COUNTER_LARGE_PAGES_DATASET_FAILED,
+  RX_COUNTER_LARGE_PAGES_VM_OK,
+  RX_COUNTER_LARGE_PAGES_VM_FAILED,
+  RX_COUNTERS
+};
+
+enum rx_timer {
+  RX_TIMER_HASH,
+  RX_TIMER_CACHE_REBUILD,
+  RX_TIMER_DATASET_REBUILD,
+  RX_TIMER_VM_CREATE,
+  RX_TIMER_ALT_WAIT,
+  RX_TIMERS
+};
+
+void rx_metric_inc(enum rx_counter counter);
+void rx_metric_observe_ns(enum rx_timer timer, uint64_t ns);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //QRANDOMX_RX_METRICS_H
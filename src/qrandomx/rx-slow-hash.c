@@ -33,9 +33,16 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <unistd.h>
+#include <time.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #include "RandomX/src/randomx.h"
 #include "c_threads.h"
+#include "rx-metrics.h"
+#include "largepages.h"
+#include "misc/tracing.h"
 
 #define HASH_SIZE	32
 
@@ -59,7 +66,34 @@ static rx_state rx_s[2] = {{CTHR_MUTEX_INIT,{0},0,0},{CTHR_MUTEX_INIT,{0},0,0}};
 
 static randomx_dataset *rx_dataset;
 static uint64_t rx_dataset_height;
+static int rx_dataset_failed;
+/* hashes running on the dataset; a release waits for the last of them, new ones stay light */
+static unsigned rx_dataset_users;
+static int rx_dataset_release;
+/* bumped when the dataset is freed, full VMs of an older generation point at freed memory */
+static unsigned rx_dataset_generation;
+static unsigned rx_full_mem_vms;
 static THREADV randomx_vm *rx_vm = NULL;
+static THREADV int rx_vm_full_mem = 0;
+static THREADV unsigned rx_vm_generation = 0;
+static THREADV unsigned rx_vm_dataset_generation = 0;
+
+/* cache init, dataset init and VM creation time of this thread's last rx_slow_hash */
+enum { RX_PHASE_CACHE, RX_PHASE_DATASET, RX_PHASE_VM, RX_PHASES };
+static THREADV uint64_t rx_phase_ns[RX_PHASES];
+
+static uint64_t rx_now_ns(void) {
+#ifdef _WIN32
+  LARGE_INTEGER count, frequency;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&frequency);
+  return (uint64_t)((double)count.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+}
 
 static void local_abort(const char *msg)
 {
@@ -71,41 +105,72 @@ static void local_abort(const char *msg)
 #endif
 }
 
-static inline int disabled_flags(void) {
-  static int flags = -1;
-
-  if (flags != -1) {
-    return flags;
-  }
-
+/* New caches and VMs use the flags randomx_get_flags() detected plus the forced ones, minus
+ * the masked ones. The mask starts out as MONERO_RANDOMX_UMASK. Every change bumps the
+ * generation, so that each thread recreates its VM at its next hash. */
+static CTHR_MUTEX_TYPE rx_flags_mutex = CTHR_MUTEX_INIT;
+static int rx_flags_detected = -1;
+static int rx_flags_forced;
+static int rx_flags_masked = -1;
+static int rx_flags_last_vm;
+static unsigned rx_flags_generation;
+
+static int rx_umask(void) {
   const char *env = getenv("MONERO_RANDOMX_UMASK");
   if (!env) {
-    flags = 0;
+    return 0;
   }
-  else {
-    char* endptr;
-    long int value = strtol(env, &endptr, 0);
-    if (endptr != env && value >= 0 && value < INT_MAX) {
-      flags = value;
-    }
-    else {
-      flags = 0;
-    }
+  char* endptr;
+  long int value = strtol(env, &endptr, 0);
+  if (endptr != env && value >= 0 && value < INT_MAX) {
+    return value;
   }
+  return 0;
+}
 
-  return flags;
+/* call with rx_flags_mutex held */
+static void rx_flags_init(void) {
+  if (rx_flags_detected == -1)
+    rx_flags_detected = randomx_get_flags();
+  if (rx_flags_masked == -1)
+    rx_flags_masked = rx_umask();
 }
 
-static inline int enabled_flags(void) {
-  static int flags = -1;
+/* the flags for new caches and VMs, plus the mask and generation they come from */
+static randomx_flags rx_current_flags(int *masked, unsigned *generation) {
+  randomx_flags flags;
+  CTHR_MUTEX_LOCK(rx_flags_mutex);
+  rx_flags_init();
+  flags = (rx_flags_detected | rx_flags_forced) & ~rx_flags_masked;
+  if (masked)
+    *masked = rx_flags_masked;
+  if (generation)
+    *generation = rx_flags_generation;
+  CTHR_MUTEX_UNLOCK(rx_flags_mutex);
+  return flags;
+}
 
-  if (flags != -1) {
-    return flags;
-  }
+void rx_get_flags(int *detected, int *forced, int *masked, int *last_vm) {
+  CTHR_MUTEX_LOCK(rx_flags_mutex);
+  rx_flags_init();
+  *detected = rx_flags_detected;
+  *forced = rx_flags_forced;
+  *masked = rx_flags_masked;
+  *last_vm = rx_flags_last_vm;
+  CTHR_MUTEX_UNLOCK(rx_flags_mutex);
+}
 
-  flags = randomx_get_flags();
+void rx_set_flags_override(int forced, int masked) {
+  CTHR_MUTEX_LOCK(rx_flags_mutex);
+  rx_flags_init();
+  rx_flags_forced = forced;
+  rx_flags_masked = masked;
+  rx_flags_generation++;
+  CTHR_MUTEX_UNLOCK(rx_flags_mutex);
+}
 
-  return flags;
+void rx_reset_flags_override(void) {
+  rx_set_flags_override(0, rx_umask());
 }
 
 #define SEEDHASH_EPOCH_BLOCKS	2048	/* Must be same as BLOCKS_SYNCHRONIZING_MAX_COUNT in cryptonote_config.h */
@@ -135,6 +200,169 @@ void rx_seedheights(const uint64_t height, uint64_t *seedheight, uint64_t *nexth
   *nextheight = rx_seedheight(height + SEEDHASH_EPOCH_LAG);
 }
 
+/* large page policy and outcome per allocation type, see largepages.h */
+#define RX_ALLOCATIONS	3
+#define RX_HUGEPAGE_SIZE	(2UL * 1024 * 1024)
+
+static CTHR_MUTEX_TYPE rx_pages_mutex = CTHR_MUTEX_INIT;
+static int rx_pages_policy[RX_ALLOCATIONS] = {LARGE_PAGES_PREFER, LARGE_PAGES_PREFER, LARGE_PAGES_PREFER};
+static int rx_pages_backing[RX_ALLOCATIONS];
+
+static int rx_get_pages_policy(int allocation) {
+  int policy;
+  CTHR_MUTEX_LOCK(rx_pages_mutex);
+  policy = rx_pages_policy[allocation];
+  CTHR_MUTEX_UNLOCK(rx_pages_mutex);
+  return policy;
+}
+
+static void rx_set_pages_backing(int allocation, int backing) {
+  CTHR_MUTEX_LOCK(rx_pages_mutex);
+  rx_pages_backing[allocation] = backing;
+  CTHR_MUTEX_UNLOCK(rx_pages_mutex);
+}
+
+void rx_set_large_pages_policy(int allocation, int policy) {
+  CTHR_MUTEX_LOCK(rx_pages_mutex);
+  rx_pages_policy[allocation] = policy;
+  CTHR_MUTEX_UNLOCK(rx_pages_mutex);
+}
+
+int rx_large_pages_policy(int allocation) {
+  return rx_get_pages_policy(allocation);
+}
+
+int rx_page_backing(int allocation) {
+  int backing;
+  CTHR_MUTEX_LOCK(rx_pages_mutex);
+  backing = rx_pages_backing[allocation];
+  CTHR_MUTEX_UNLOCK(rx_pages_mutex);
+  return backing;
+}
+
+/* asks for transparent huge pages on the 2 MiB aligned part of a not yet touched region */
+static int rx_madvise_hugepages(void *memory, size_t size) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+  uintptr_t start = ((uintptr_t)memory + RX_HUGEPAGE_SIZE - 1) & ~(RX_HUGEPAGE_SIZE - 1);
+  uintptr_t end = ((uintptr_t)memory + size) & ~(RX_HUGEPAGE_SIZE - 1);
+  if (memory == NULL || end <= start)
+    return 0;
+  return madvise((void *)start, end - start, MADV_HUGEPAGE) == 0;
+#else
+  (void)memory;
+  (void)size;
+  return 0;
+#endif
+}
+
+/* NULL if it cannot be allocated under the cache policy */
+static randomx_cache *rx_alloc_cache(randomx_flags flags) {
+  int policy = rx_get_pages_policy(ALLOCATION_CACHE);
+  randomx_cache *cache = NULL;
+
+  if (policy != LARGE_PAGES_OFF) {
+    cache = randomx_alloc_cache(flags | RANDOMX_FLAG_LARGE_PAGES);
+    rx_metric_inc(cache ? RX_COUNTER_LARGE_PAGES_CACHE_OK : RX_COUNTER_LARGE_PAGES_CACHE_FAILED);
+    if (cache != NULL) {
+      rx_set_pages_backing(ALLOCATION_CACHE, PAGES_LARGE);
+      return cache;
+    }
+  }
+  if (policy == LARGE_PAGES_REQUIRE)
+    return NULL;
+  cache = randomx_alloc_cache(flags);
+  if (cache != NULL)
+    rx_set_pages_backing(ALLOCATION_CACHE, PAGES_NORMAL);
+  return cache;
+}
+
+/* NULL if it cannot be allocated under the dataset policy, call with rx_dataset_mutex held */
+static randomx_dataset *rx_alloc_dataset(void) {
+  int policy = rx_get_pages_policy(ALLOCATION_DATASET);
+  randomx_dataset *dataset = NULL;
+
+  if (policy != LARGE_PAGES_OFF) {
+    dataset = randomx_alloc_dataset(RANDOMX_FLAG_LARGE_PAGES);
+    rx_metric_inc(dataset ? RX_COUNTER_LARGE_PAGES_DATASET_OK : RX_COUNTER_LARGE_PAGES_DATASET_FAILED);
+    if (dataset != NULL)
+      rx_set_pages_backing(ALLOCATION_DATASET, PAGES_LARGE);
+  }
+  if (dataset == NULL && policy != LARGE_PAGES_REQUIRE) {
+    dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
+    /* the dataset is only touched by rx_initdata, so its pages can still be huge ones */
+    if (dataset != NULL)
+      rx_set_pages_backing(ALLOCATION_DATASET,
+                           policy != LARGE_PAGES_OFF && rx_madvise_hugepages(randomx_get_dataset_memory(dataset),
+                               (size_t)randomx_dataset_item_count() * RANDOMX_DATASET_ITEM_SIZE)
+                           ? PAGES_TRANSPARENT : PAGES_NORMAL);
+  }
+  if (dataset != NULL)
+    rx_dataset_height = 1;	/* invalid seed height, forces init */
+  return dataset;
+}
+
+/* call with rx_dataset_mutex held */
+static void rx_free_dataset(void) {
+  if (rx_dataset != NULL) {
+    randomx_release_dataset(rx_dataset);
+    rx_dataset = NULL;
+    rx_set_pages_backing(ALLOCATION_DATASET, PAGES_UNALLOCATED);
+  }
+  rx_dataset_release = 0;
+  rx_dataset_generation++;
+}
+
+/* call with rx_dataset_mutex held */
+static void rx_dataset_unpin(void) {
+  if (--rx_dataset_users == 0 && rx_dataset_release)
+    rx_free_dataset();
+}
+
+static void rx_destroy_thread_vm(void) {
+  if (rx_vm_full_mem) {
+    CTHR_MUTEX_LOCK(rx_dataset_mutex);
+    rx_full_mem_vms--;
+    CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  }
+  randomx_destroy_vm(rx_vm);
+  rx_vm = NULL;
+  rx_vm_full_mem = 0;
+}
+
+static void rx_set_last_vm_flags(int flags) {
+  CTHR_MUTEX_LOCK(rx_flags_mutex);
+  rx_flags_last_vm = flags;
+  CTHR_MUTEX_UNLOCK(rx_flags_mutex);
+}
+
+/* NULL only if the VM policy requires large pages and there are none */
+static randomx_vm *rx_create_vm(randomx_flags flags, randomx_cache *cache, randomx_dataset *dataset) {
+  int policy = rx_get_pages_policy(ALLOCATION_VM);
+  randomx_vm *vm = NULL;
+
+  if (policy != LARGE_PAGES_OFF) {
+    vm = randomx_create_vm(flags | RANDOMX_FLAG_LARGE_PAGES, cache, dataset);
+    rx_metric_inc(vm ? RX_COUNTER_LARGE_PAGES_VM_OK : RX_COUNTER_LARGE_PAGES_VM_FAILED);
+    if (vm != NULL) {
+      rx_set_pages_backing(ALLOCATION_VM, PAGES_LARGE);
+      rx_set_last_vm_flags(flags | RANDOMX_FLAG_LARGE_PAGES);
+      return vm;
+    }
+    if (policy == LARGE_PAGES_REQUIRE)
+      return NULL;
+  }
+  vm = randomx_create_vm(flags, cache, dataset);
+  if (vm == NULL) {	/* fallback if everything fails */
+    flags = RANDOMX_FLAG_DEFAULT | (flags & RANDOMX_FLAG_FULL_MEM);
+    vm = randomx_create_vm(flags, cache, dataset);
+  }
+  if (vm == NULL)
+    local_abort("Couldn't allocate RandomX VM");
+  rx_set_pages_backing(ALLOCATION_VM, PAGES_NORMAL);
+  rx_set_last_vm_flags(flags);
+  return vm;
+}
+
 typedef struct seedinfo {
     randomx_cache *si_cache;
     unsigned long si_start;
@@ -148,6 +376,8 @@ static CTHR_THREAD_RTYPE rx_seedthread(void *arg) {
 }
 
 static void rx_initdata(randomx_cache *rs_cache, const int miners, const uint64_t seedheight) {
+  uint64_t start_ns = rx_now_ns();
+  QRX_TRACE_START(trace_start);
   if (miners > 1) {
     unsigned long delta = randomx_dataset_item_count() / miners;
     unsigned long start = 0;
@@ -184,17 +414,30 @@ static void rx_initdata(randomx_cache *rs_cache, const int miners, const uint64_
     randomx_init_dataset(rx_dataset, rs_cache, 0, randomx_dataset_item_count());
   }
   rx_dataset_height = seedheight;
+  QRX_TRACE_END(trace_start, "rx.dataset_init");
+  start_ns = rx_now_ns() - start_ns;
+  rx_phase_ns[RX_PHASE_DATASET] += start_ns;
+  rx_metric_inc(RX_COUNTER_DATASET_REBUILDS);
+  rx_metric_observe_ns(RX_TIMER_DATASET_REBUILD, start_ns);
 }
 
 void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash, const void *data, size_t length,
                   char *hash, int miners, int is_alt) {
   uint64_t s_height = rx_seedheight(mainheight);
   int toggle = (s_height & SEEDHASH_EPOCH_BLOCKS) != 0;
-  randomx_flags flags = enabled_flags() & ~disabled_flags();
+  int masked;
+  unsigned generation;
+  randomx_flags flags = rx_current_flags(&masked, &generation);
   rx_state *rx_sp;
   randomx_cache *cache;
+  unsigned dataset_generation = 0;
+  uint64_t start_ns = 0;
+  uint64_t call_ns = rx_now_ns();
+  QRX_TRACE_START(trace_start);
 
+  memset(rx_phase_ns, 0, sizeof(rx_phase_ns));
   CTHR_MUTEX_LOCK(rx_mutex);
+  QRX_TRACE_END(trace_start, "rx.wait_rx_mutex");
 
   /* if alt block but with same seed as mainchain, no need for alt cache */
   if (is_alt) {
@@ -212,60 +455,101 @@ void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const ch
   toggle ^= (is_alt != 0);
 
   rx_sp = &rx_s[toggle];
-  CTHR_MUTEX_LOCK(rx_sp->rs_mutex);
+  if (!CTHR_MUTEX_TRYLOCK(rx_sp->rs_mutex)) {
+    QRX_TRACE_START(trace_wait);
+    start_ns = rx_now_ns();
+    CTHR_MUTEX_LOCK(rx_sp->rs_mutex);
+    QRX_TRACE_END(trace_wait, is_alt ? "rx.wait_alt_slot" : "rx.wait_main_slot");
+    if (is_alt) {
+      rx_metric_inc(RX_COUNTER_ALT_CONTENDED);
+      rx_metric_observe_ns(RX_TIMER_ALT_WAIT, rx_now_ns() - start_ns);
+    }
+    start_ns = 0;
+  }
   CTHR_MUTEX_UNLOCK(rx_mutex);
 
   cache = rx_sp->rs_cache;
   if (cache == NULL) {
-    if (cache == NULL) {
-      cache = randomx_alloc_cache(flags | RANDOMX_FLAG_LARGE_PAGES);
-      if (cache == NULL) {
-        cache = randomx_alloc_cache(flags);
-      }
-      if (cache == NULL)
-        local_abort("Couldn't allocate RandomX cache");
-    }
+    start_ns = rx_now_ns();
+    cache = rx_alloc_cache(flags);
+    if (cache == NULL)
+      local_abort(rx_get_pages_policy(ALLOCATION_CACHE) == LARGE_PAGES_REQUIRE ?
+                  "Couldn't allocate RandomX cache in large pages" : "Couldn't allocate RandomX cache");
   }
   if (rx_sp->rs_height != seedheight || rx_sp->rs_cache == NULL || memcmp(seedhash, rx_sp->rs_hash, HASH_SIZE)) {
+    if (start_ns == 0)
+      start_ns = rx_now_ns();
+    QRX_TRACE_START(trace_cache);
     randomx_init_cache(cache, seedhash, HASH_SIZE);
     rx_sp->rs_cache = cache;
     rx_sp->rs_height = seedheight;
     memcpy(rx_sp->rs_hash, seedhash, HASH_SIZE);
+    rx_phase_ns[RX_PHASE_CACHE] = rx_now_ns() - start_ns;
+    QRX_TRACE_END(trace_cache, "rx.cache_init");
+    rx_metric_inc(RX_COUNTER_SEED_CACHE_MISSES);
+    rx_metric_observe_ns(RX_TIMER_CACHE_REBUILD, rx_phase_ns[RX_PHASE_CACHE]);
+  } else {
+    rx_metric_inc(RX_COUNTER_SEED_CACHE_HITS);
+  }
+  /* a masked FULL_MEM flag keeps miners light as well */
+  if (miners && (masked & RANDOMX_FLAG_FULL_MEM)) {
+    miners = 0;
+  }
+  if (miners) {
+    CTHR_MUTEX_LOCK(rx_dataset_mutex);
+    /* once the dataset could not be allocated, stay in light mode,
+     * likewise while it is being released */
+    if (rx_dataset_failed || rx_dataset_release)
+      miners = 0;
+    else
+      rx_dataset_users++;	/* the dataset cannot be freed until this hash is done */
+    dataset_generation = rx_dataset_generation;
+    CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  }
+  /* a light VM cannot use the dataset and a full VM ignores the cache,
+   * and the flags or the dataset may have changed since this thread created its VM */
+  if (rx_vm != NULL && (rx_vm_full_mem != (miners != 0) || rx_vm_generation != generation ||
+                        (miners && rx_vm_dataset_generation != dataset_generation))) {
+    rx_destroy_thread_vm();
   }
   if (rx_vm == NULL) {
     if ((flags & RANDOMX_FLAG_JIT) && !miners) {
-      flags |= RANDOMX_FLAG_SECURE & ~disabled_flags();
-    }
-    if (miners && (disabled_flags() & RANDOMX_FLAG_FULL_MEM)) {
-      miners = 0;
+      flags |= RANDOMX_FLAG_SECURE & ~masked;
     }
     if (miners) {
       CTHR_MUTEX_LOCK(rx_dataset_mutex);
       if (rx_dataset == NULL) {
-        rx_dataset = randomx_alloc_dataset(RANDOMX_FLAG_LARGE_PAGES);
-        if (rx_dataset == NULL) {
-          rx_dataset = randomx_alloc_dataset(RANDOMX_FLAG_DEFAULT);
-        }
-        if (rx_dataset != NULL)
-          rx_initdata(rx_sp->rs_cache, miners, seedheight);
+        start_ns = rx_now_ns();
+        rx_dataset = rx_alloc_dataset();
+        if (rx_dataset == NULL && rx_get_pages_policy(ALLOCATION_DATASET) == LARGE_PAGES_REQUIRE)
+          local_abort("Couldn't allocate RandomX dataset in large pages");
+        rx_dataset_failed = rx_dataset == NULL;
+        rx_phase_ns[RX_PHASE_DATASET] += rx_now_ns() - start_ns;
       }
-      if (rx_dataset != NULL)
+      if (rx_dataset != NULL) {
+        if (rx_dataset_height != seedheight)
+          rx_initdata(rx_sp->rs_cache, miners, seedheight);
         flags |= RANDOMX_FLAG_FULL_MEM;
+        rx_full_mem_vms++;
+      }
       else {
+        rx_dataset_unpin();
         miners = 0;
       }
       CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
     }
-    rx_vm = randomx_create_vm(flags | RANDOMX_FLAG_LARGE_PAGES, rx_sp->rs_cache, rx_dataset);
-    if(rx_vm == NULL) { //large pages failed
-      rx_vm = randomx_create_vm(flags, rx_sp->rs_cache, rx_dataset);
-    }
-    if(rx_vm == NULL) {//fallback if everything fails
-      flags = RANDOMX_FLAG_DEFAULT | (miners ? RANDOMX_FLAG_FULL_MEM : 0);
-      rx_vm = randomx_create_vm(flags, rx_sp->rs_cache, rx_dataset);
-    }
+    start_ns = rx_now_ns();
+    QRX_TRACE_START(trace_vm);
+    rx_vm = rx_create_vm(flags, rx_sp->rs_cache, miners ? rx_dataset : NULL);
     if (rx_vm == NULL)
-      local_abort("Couldn't allocate RandomX VM");
+      local_abort("Couldn't allocate RandomX VM in large pages");
+    rx_vm_full_mem = (miners != 0);
+    rx_vm_generation = generation;
+    rx_vm_dataset_generation = dataset_generation;
+    rx_phase_ns[RX_PHASE_VM] = rx_now_ns() - start_ns;
+    QRX_TRACE_END(trace_vm, "rx.vm_create");
+    rx_metric_inc(RX_COUNTER_VM_CREATIONS);
+    rx_metric_observe_ns(RX_TIMER_VM_CREATE, rx_phase_ns[RX_PHASE_VM]);
   } else if (miners) {
     CTHR_MUTEX_LOCK(rx_dataset_mutex);
     if (rx_dataset != NULL && rx_dataset_height != seedheight)
@@ -278,28 +562,187 @@ void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const ch
   /* mainchain users can run in parallel */
   if (!is_alt)
     CTHR_MUTEX_UNLOCK(rx_sp->rs_mutex);
+  QRX_TRACE_START(trace_hash);
   randomx_calculate_hash(rx_vm, data, length, hash);
+  QRX_TRACE_END(trace_hash, "rx.calculate_hash");
   /* altchain slot users always get fully serialized */
   if (is_alt)
     CTHR_MUTEX_UNLOCK(rx_sp->rs_mutex);
+  if (miners) {
+    CTHR_MUTEX_LOCK(rx_dataset_mutex);
+    rx_dataset_unpin();
+    CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  }
+  rx_metric_inc(RX_COUNTER_HASHES);
+  rx_metric_observe_ns(RX_TIMER_HASH, rx_now_ns() - call_ns);
+}
+
+void rx_last_phase_times(uint64_t *cache_ns, uint64_t *dataset_ns, uint64_t *vm_ns) {
+  *cache_ns = rx_phase_ns[RX_PHASE_CACHE];
+  *dataset_ns = rx_phase_ns[RX_PHASE_DATASET];
+  *vm_ns = rx_phase_ns[RX_PHASE_VM];
 }
 
 void rx_slow_hash_allocate_state(void) {
 }
 
 void rx_slow_hash_free_state(void) {
-  if (rx_vm != NULL) {
-    randomx_destroy_vm(rx_vm);
-    rx_vm = NULL;
+  if (rx_vm != NULL)
+    rx_destroy_thread_vm();
+}
+
+/* Dedicated slot for batch verification. The owner of rx_batch_mutex pins the
+ * cache to one seed for the whole batch, so any number of threads can hash
+ * with it in parallel, each with its own light VM. */
+static CTHR_MUTEX_TYPE rx_batch_mutex = CTHR_MUTEX_INIT;
+static rx_state rx_batch = {CTHR_MUTEX_INIT,{0},0,0};
+static THREADV randomx_vm *rx_batch_vm = NULL;
+static THREADV unsigned rx_batch_vm_generation = 0;
+/* the flags of the current batch, written by the owner of rx_batch_mutex */
+static randomx_flags rx_batch_flags;
+static int rx_batch_masked;
+static unsigned rx_batch_generation;
+
+/* true if rx_slow_hash would promote an alt request for this seed to the mainchain cache */
+int rx_seed_cached(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash) {
+  uint64_t s_height = rx_seedheight(mainheight);
+  int toggle = (s_height & SEEDHASH_EPOCH_BLOCKS) != 0;
+  int cached;
+
+  CTHR_MUTEX_LOCK(rx_mutex);
+  cached = s_height == seedheight && rx_s[toggle].rs_cache != NULL && !memcmp(rx_s[toggle].rs_hash, seedhash, HASH_SIZE);
+  CTHR_MUTEX_UNLOCK(rx_mutex);
+  return cached;
+}
+
+void rx_batch_lock(const uint64_t seedheight, const char *seedhash) {
+  int masked;
+  unsigned generation;
+  randomx_flags flags = rx_current_flags(&masked, &generation);
+
+  CTHR_MUTEX_LOCK(rx_batch_mutex);
+  /* nobody else hashes with the batch cache, so it can follow flag changes */
+  if (rx_batch.rs_cache != NULL && rx_batch_generation != generation) {
+    randomx_release_cache(rx_batch.rs_cache);
+    rx_batch.rs_cache = NULL;
+  }
+  rx_batch_flags = flags;
+  rx_batch_masked = masked;
+  rx_batch_generation = generation;
+  if (rx_batch.rs_cache == NULL) {
+    rx_batch.rs_cache = rx_alloc_cache(flags);
+    if (rx_batch.rs_cache == NULL)
+      local_abort(rx_get_pages_policy(ALLOCATION_CACHE) == LARGE_PAGES_REQUIRE ?
+                  "Couldn't allocate RandomX cache in large pages" : "Couldn't allocate RandomX cache");
+    rx_batch.rs_height = 1;	/* invalid seed height, forces init */
+  }
+  if (rx_batch.rs_height != seedheight || memcmp(rx_batch.rs_hash, seedhash, HASH_SIZE)) {
+    uint64_t start_ns = rx_now_ns();
+    QRX_TRACE_START(trace_cache);
+    randomx_init_cache(rx_batch.rs_cache, seedhash, HASH_SIZE);
+    rx_batch.rs_height = seedheight;
+    memcpy(rx_batch.rs_hash, seedhash, HASH_SIZE);
+    QRX_TRACE_END(trace_cache, "rx.batch_cache_init");
+    rx_metric_inc(RX_COUNTER_SEED_CACHE_MISSES);
+    rx_metric_observe_ns(RX_TIMER_CACHE_REBUILD, rx_now_ns() - start_ns);
+  } else {
+    rx_metric_inc(RX_COUNTER_SEED_CACHE_HITS);
   }
 }
 
-void rx_stop_mining(void) {
-  CTHR_MUTEX_LOCK(rx_dataset_mutex);
-  if (rx_dataset != NULL) {
-    randomx_dataset *rd = rx_dataset;
-    rx_dataset = NULL;
-    randomx_release_dataset(rd);
+void rx_batch_hash(const void *data, size_t length, char *hash) {
+  if (rx_batch_vm != NULL && rx_batch_vm_generation != rx_batch_generation) {
+    randomx_destroy_vm(rx_batch_vm);
+    rx_batch_vm = NULL;
   }
+  if (rx_batch_vm == NULL) {
+    randomx_flags flags = rx_batch_flags;
+    if (flags & RANDOMX_FLAG_JIT)
+      flags |= RANDOMX_FLAG_SECURE & ~rx_batch_masked;
+    rx_batch_vm = rx_create_vm(flags, rx_batch.rs_cache, NULL);
+    if (rx_batch_vm == NULL)
+      local_abort("Couldn't allocate RandomX VM in large pages");
+    rx_batch_vm_generation = rx_batch_generation;
+    rx_metric_inc(RX_COUNTER_VM_CREATIONS);
+  } else {
+    /* this is a no-op if the cache hasn't changed */
+    randomx_vm_set_cache(rx_batch_vm, rx_batch.rs_cache);
+  }
+  QRX_TRACE_START(trace_hash);
+  randomx_calculate_hash(rx_batch_vm, data, length, hash);
+  QRX_TRACE_END(trace_hash, "rx.batch_calculate_hash");
+  rx_metric_inc(RX_COUNTER_BATCH_HASHES);
+}
+
+void rx_batch_unlock(void) {
+  CTHR_MUTEX_UNLOCK(rx_batch_mutex);
+}
+
+void rx_batch_free_state(void) {
+  if (rx_batch_vm != NULL) {
+    randomx_destroy_vm(rx_batch_vm);
+    rx_batch_vm = NULL;
+  }
+}
+
+int rx_dataset_available(void) {
+  int available;
+  CTHR_MUTEX_LOCK(rx_dataset_mutex);
+  available = rx_dataset != NULL;
+  CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  return available;
+}
+
+int rx_full_mem_vm_count(void) {
+  int count;
+  CTHR_MUTEX_LOCK(rx_dataset_mutex);
+  count = (int)rx_full_mem_vms;
   CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  return count;
+}
+
+/* the full VMs left behind are recreated at their next hash, a failed allocation can be retried */
+void rx_release_dataset(void) {
+  CTHR_MUTEX_LOCK(rx_dataset_mutex);
+  rx_dataset_failed = 0;
+  if (rx_dataset_users)
+    rx_dataset_release = 1;
+  else
+    rx_free_dataset();
+  CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+}
+
+/* allocation types that failed, as 1 << RandomXAllocation */
+int rx_preallocate(int dataset) {
+  int masked;
+  randomx_flags flags = rx_current_flags(&masked, NULL);
+  int failed = 0;
+  int i;
+
+  CTHR_MUTEX_LOCK(rx_mutex);
+  for (i=0; i<2; i++) {
+    CTHR_MUTEX_LOCK(rx_s[i].rs_mutex);
+    if (rx_s[i].rs_cache == NULL) {
+      rx_s[i].rs_cache = rx_alloc_cache(flags);
+      if (rx_s[i].rs_cache == NULL)
+        failed |= 1 << ALLOCATION_CACHE;
+      rx_s[i].rs_height = 1;	/* invalid seed height, forces init */
+    }
+    CTHR_MUTEX_UNLOCK(rx_s[i].rs_mutex);
+  }
+  CTHR_MUTEX_UNLOCK(rx_mutex);
+
+  if (dataset && !(masked & RANDOMX_FLAG_FULL_MEM)) {
+    CTHR_MUTEX_LOCK(rx_dataset_mutex);
+    if (rx_dataset == NULL) {
+      rx_dataset = rx_alloc_dataset();
+      if (rx_dataset == NULL)
+        failed |= 1 << ALLOCATION_DATASET;
+    }
+    /* hashes that fell back to light mode can use it from now on */
+    if (rx_dataset != NULL)
+      rx_dataset_failed = 0;
+    CTHR_MUTEX_UNLOCK(rx_dataset_mutex);
+  }
+  return failed;
 }
\ No newline at end of file
@@ -41,5 +41,24 @@ uint64_t rx_seedheight(const uint64_t height);
 void rx_slow_hash(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash, const void *data, size_t length,
                   char *hash, int miners, int is_alt);
 void rx_slow_hash_free_state(void);
+void rx_last_phase_times(uint64_t *cache_ns, uint64_t *dataset_ns, uint64_t *vm_ns);
+int rx_dataset_available(void);
+int rx_full_mem_vm_count(void);
+void rx_release_dataset(void);
+
+void rx_set_large_pages_policy(int allocation, int policy);
+int rx_large_pages_policy(int allocation);
+int rx_page_backing(int allocation);
+int rx_preallocate(int dataset);
+
+void rx_get_flags(int *detected, int *forced, int *masked, int *last_vm);
+void rx_set_flags_override(int forced, int masked);
+void rx_reset_flags_override(void);
+
+int rx_seed_cached(const uint64_t mainheight, const uint64_t seedheight, const char *seedhash);
+void rx_batch_lock(const uint64_t seedheight, const char *seedhash);
+void rx_batch_hash(const void *data, size_t length, char *hash);
+void rx_batch_unlock(void);
+void rx_batch_free_state(void);
 }
 #endif //QRANDOMX_RX_SLOW_HASH_H
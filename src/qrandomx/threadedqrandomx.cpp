@@ -23,6 +23,8 @@
 
 #include "threadedqrandomx.h"
 #include "qrandomx/qrandomx.h"
+#include "misc/tracing.h"
+#include <stdexcept>
 
 ThreadedQRandomX::ThreadedQRandomX() {
   _eventThread = std::make_unique<std::thread>([&]() { _threadedQRandomXProxy(); });
@@ -38,6 +40,11 @@ ThreadedQRandomX::~ThreadedQRandomX() {
 }
 
 void ThreadedQRandomX::_submitWork(std::shared_ptr<QRandomXParams>& qrxParams) {
+#ifdef QRANDOMX_TRACING
+  static std::atomic<uint64_t> next_trace_id{1};
+  qrxParams->traceId = next_trace_id++;
+  qrxParams->traceSubmitNs = qrx_trace_now();
+#endif
   std::lock_guard<std::mutex> lock_queue(_eventQueue_mutex);
   _eventQueue.push_back(qrxParams);
   _eventReleased.notify_one();
@@ -59,6 +66,7 @@ uint64_t ThreadedQRandomX::getSeedHeight(const uint64_t blockNumber) {
 std::vector<uint8_t> ThreadedQRandomX::hash(const uint64_t mainHeight,
         const uint64_t seedHeight, const std::vector<uint8_t>& seedHash,
         const std::vector<uint8_t>& input, int miners, int is_alt) {
+  QRX_TRACE_START(trace_start);
 
   std::shared_ptr<QRandomXParams> qrxParams = std::make_shared<QRandomXParams>(mainHeight,
           seedHeight, seedHash, input, miners, is_alt);
@@ -67,10 +75,34 @@ std::vector<uint8_t> ThreadedQRandomX::hash(const uint64_t mainHeight,
   // Check outputReady
   std::unique_lock<std::mutex> outputQLock(qrxParams->_outputQueue_mutex);
   qrxParams->_outputReady.wait(outputQLock, [=] { return !qrxParams->_output.empty() || _stop_eventThread; });
+  QRX_TRACE_END_ID(trace_start, "threadedqrandomx.hash", qrxParams->traceId);
 
   return qrxParams->_output.front().hashOutput;
 }
 
+void ThreadedQRandomX::hashInto(const uint64_t mainHeight, const uint64_t seedHeight,
+        const uint8_t *seedHash, size_t seedHash_len,
+        const uint8_t *input, size_t input_len,
+        uint8_t *output, size_t output_len,
+        int miners, int is_alt) {
+  if (seedHash_len!=32) {
+    throw std::invalid_argument("seedHash must be 32 bytes");
+  }
+  if (output_len<32) {
+    throw std::invalid_argument("output must hold at least 32 bytes");
+  }
+  QRX_TRACE_START(trace_start);
+
+  std::shared_ptr<QRandomXParams> qrxParams = std::make_shared<QRandomXParams>(mainHeight,
+          seedHeight, seedHash, input, input_len, output, miners, is_alt);
+  _submitWork(qrxParams);
+
+  // the proxy thread reads and writes the buffers directly, so wait for it even if stopping
+  std::unique_lock<std::mutex> outputQLock(qrxParams->_outputQueue_mutex);
+  qrxParams->_outputReady.wait(outputQLock, [=] { return !qrxParams->_output.empty(); });
+  QRX_TRACE_END_ID(trace_start, "threadedqrandomx.hash", qrxParams->traceId);
+}
+
 void ThreadedQRandomX::_threadedQRandomXProxy() {
   std::unique_ptr<QRandomX> qrx(new QRandomX);
   while (!_stop_eventThread) {
@@ -88,6 +120,11 @@ void ThreadedQRandomX::_threadedQRandomXProxy() {
 
       // Process Request
       for(const auto& event: events) {
+#ifdef QRANDOMX_TRACING
+        // time spent queued behind other requests
+        qrx_trace_record("threadedqrandomx.queue", event->traceSubmitNs, qrx_trace_now(), event->traceId);
+#endif
+        QRX_TRACE_SCOPE_ID("threadedqrandomx.process", event->traceId);
         QRandomXProxyResult qrxResult;
         switch (event->funcType) {
           case 0:
@@ -100,6 +137,11 @@ void ThreadedQRandomX::_threadedQRandomXProxy() {
           case 2:
             qrx->freeVM();
             break;
+          case 3:
+            QRandomX::hash(event->mainHeight, event->seedHeight, event->seedHashBuffer,
+                           event->inputBuffer, event->inputLength, event->outputBuffer,
+                           event->miners, event->is_alt);
+            break;
         }
         // Notify output is ready
         std::lock_guard<std::mutex> lock_queue(event->_outputQueue_mutex);
@@ -58,6 +58,29 @@ public:
     this->is_alt = is_alt;
   }
 
+#ifndef SWIG
+  // Hashes straight from/into the caller's buffers, which must stay alive until the
+  // result is posted
+  QRandomXParams(uint64_t mainHeight,
+                 uint64_t seedHeight,
+                 const uint8_t *seedHashBuffer,
+                 const uint8_t *inputBuffer,
+                 size_t inputLength,
+                 uint8_t *outputBuffer,
+                 uint32_t miners,
+                 int is_alt) {
+    this->mainHeight = mainHeight;
+    this->seedHeight = seedHeight;
+    this->seedHashBuffer = seedHashBuffer;
+    this->inputBuffer = inputBuffer;
+    this->inputLength = inputLength;
+    this->outputBuffer = outputBuffer;
+    this->miners = miners;
+    this->funcType = 3;
+    this->is_alt = is_alt;
+  }
+#endif
+
   uint64_t mainHeight;
   uint64_t seedHeight;
   std::vector<uint8_t> seedHash;
@@ -65,6 +88,13 @@ public:
   uint32_t miners;
   int is_alt;
 
+#ifndef SWIG
+  const uint8_t *seedHashBuffer = nullptr;
+  const uint8_t *inputBuffer = nullptr;
+  size_t inputLength = 0;
+  uint8_t *outputBuffer = nullptr;
+#endif
+
 protected:
   std::deque<QRandomXProxyResult> _output;
   std::mutex _outputQueue_mutex;
@@ -72,6 +102,10 @@ protected:
 
   int funcType;
 
+  // QRANDOMX_TRACING builds: correlates the spans of one request across threads
+  uint64_t traceId = 0;
+  uint64_t traceSubmitNs = 0;
+
   friend class ThreadedQRandomX;
 };
 
@@ -93,6 +127,15 @@ public:
                             const uint64_t seedHeight, const std::vector<uint8_t>& seedHash,
                             const std::vector<uint8_t>& input, int miners, int is_alt=0);
 
+    // Same as hash() without converting through vectors: reads the 32-byte seedHash and the
+    // input in place and writes the 32-byte result to output (output_len >= 32). From Python
+    // any buffer-protocol object works, e.g. hashInto(h, s, seed, memoryview(blob), out, 0)
+    void hashInto(const uint64_t mainHeight, const uint64_t seedHeight,
+                  const uint8_t *seedHash, size_t seedHash_len,
+                  const uint8_t *input, size_t input_len,
+                  uint8_t *output, size_t output_len,
+                  int miners, int is_alt=0);
+
 protected:
   std::atomic_bool _stop_eventThread{false};
   std::unique_ptr<std::thread> _eventThread;
@@ -0,0 +1,123 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qrandomx/qrandomx.h>
+#include <qrandomx/threadedqrandomx.h>
+#include <qrandomx/qrandomxpool.h>
+#include <benchmark/benchmark.h>
+#include <thread>
+
+namespace {
+  const uint64_t main_height = 10;
+
+  std::vector<uint8_t> seedHash(uint8_t fill)
+  {
+    return std::vector<uint8_t>(32, fill);
+  }
+
+  std::vector<uint8_t> blob()
+  {
+    std::vector<uint8_t> input(76);
+    for (size_t i = 0; i<input.size(); i++) {
+      input[i] = static_cast<uint8_t>(i*7);
+    }
+    return input;
+  }
+
+  // light mode with a warm cache, arg 0: mainchain slot, 1: alt slot
+  void BM_RxSlowHashLight(benchmark::State &state)
+  {
+    const int is_alt = static_cast<int>(state.range(0));
+    const auto seed_height = QRandomX::getSeedHeight(main_height);
+    const auto seed = seedHash(is_alt ? 0xa1 : 0x2a);
+    auto input = blob();
+
+    QRandomX::hash(main_height, seed_height, seed, input, 0, is_alt);
+    for (auto _ : state) {
+      input[39]++;
+      benchmark::DoNotOptimize(QRandomX::hash(main_height, seed_height, seed, input, 0, is_alt));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_RxSlowHashLight)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+  // every hash needs a new cache: measures cache initialization plus one hash
+  void BM_RxSlowHashCold(benchmark::State &state)
+  {
+    const int is_alt = static_cast<int>(state.range(0));
+    const auto seed_height = QRandomX::getSeedHeight(main_height);
+    const auto input = blob();
+    uint8_t fill = 0;
+
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(QRandomX::hash(main_height, seed_height, seedHash(fill++), input, 0, is_alt));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_RxSlowHashCold)->Arg(0)->Arg(1)->Iterations(4)->Unit(benchmark::kMillisecond);
+
+  // full mode, allocates and initializes the 2 GB dataset before timing
+  void BM_RxSlowHashFull(benchmark::State &state)
+  {
+    const int miners = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    const auto seed_height = QRandomX::getSeedHeight(main_height);
+    const auto seed = seedHash(0x2a);
+    auto input = blob();
+
+    QRandomX::hash(main_height, seed_height, seed, input, miners);
+    if (!QRandomX::datasetAvailable()) {
+      state.SkipWithError("the dataset could not be allocated");
+      return;
+    }
+    for (auto _ : state) {
+      input[39]++;
+      benchmark::DoNotOptimize(QRandomX::hash(main_height, seed_height, seed, input, miners));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_RxSlowHashFull)->Unit(benchmark::kMicrosecond);
+
+  // same hash as BM_RxSlowHashLight/0 through the proxy thread, the difference is its overhead
+  void BM_ThreadedQRandomXHash(benchmark::State &state)
+  {
+    ThreadedQRandomX qrx;
+    const auto seed_height = qrx.getSeedHeight(main_height);
+    const auto seed = seedHash(0x2a);
+    auto input = blob();
+
+    qrx.hash(main_height, seed_height, seed, input, 0);
+    for (auto _ : state) {
+      input[39]++;
+      benchmark::DoNotOptimize(qrx.hash(main_height, seed_height, seed, input, 0));
+    }
+    state.SetItemsProcessed(state.iterations());
+  }
+  BENCHMARK(BM_ThreadedQRandomXHash)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+  // a proxy round trip without hashing
+  void BM_ThreadedQRandomXRoundTrip(benchmark::State &state)
+  {
+    ThreadedQRandomX qrx;
+    uint64_t height = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(qrx.getSeedHeight(height++));
+    }
+  }
+  BENCHMARK(BM_ThreadedQRandomXRoundTrip)->UseRealTime();
+
+  void BM_QRandomXPoolAcquire(benchmark::State &state)
+  {
+    static std::shared_ptr<QRandomXPool> pool;
+    if (state.thread_index()==0) {
+      pool = std::make_shared<QRandomXPool>();
+    }
+    for (auto _ : state) {
+      auto qrx = pool->acquire();
+      benchmark::DoNotOptimize(qrx.get());
+    }
+    if (state.thread_index()==0) {
+      state.counters["instances"] = static_cast<double>(pool->size());
+    }
+  }
+  BENCHMARK(BM_QRandomXPoolAcquire)->ThreadRange(1, 16)->UseRealTime();
+}
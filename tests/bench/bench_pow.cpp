@@ -0,0 +1,125 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <pow/powhelper.h>
+#include <misc/bignum.h>
+#include <misc/strbignum.h>
+#include <benchmark/benchmark.h>
+
+namespace {
+  std::vector<uint8_t> difficulty(uint64_t value)
+  {
+    std::vector<uint8_t> d(32);
+    for (int i = 31; i>=24; i--, value >>= 8) {
+      d[i] = static_cast<uint8_t>(value);
+    }
+    return d;
+  }
+
+  void BM_PassesTarget(benchmark::State &state)
+  {
+    PoWHelper ph;
+    const auto target = ph.getTarget(difficulty(5000000));
+    std::vector<uint8_t> hash(32, 0x5a);
+    for (auto _ : state) {
+      hash[0]++;
+      benchmark::DoNotOptimize(PoWHelper::passesTarget(hash, target));
+    }
+  }
+  BENCHMARK(BM_PassesTarget);
+
+  // arg 0: the same difficulty every time (target cache hit), 1: a new one every time
+  void BM_GetTarget(benchmark::State &state)
+  {
+    PoWHelper ph;
+    const bool vary = state.range(0)!=0;
+    uint64_t value = 5000000;
+    auto d = difficulty(value);
+    for (auto _ : state) {
+      if (vary) {
+        d = difficulty(++value);
+      }
+      benchmark::DoNotOptimize(ph.getTarget(d));
+    }
+  }
+  BENCHMARK(BM_GetTarget)->Arg(0)->Arg(1);
+
+  void BM_GetTargets(benchmark::State &state)
+  {
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> difficulties(count*32);
+    for (size_t i = 0; i<count; i++) {
+      auto d = difficulty(5000000+i*977);
+      std::copy(d.begin(), d.end(), difficulties.begin()+i*32);
+    }
+    std::vector<uint8_t> targets(count*32);
+    for (auto _ : state) {
+      PoWHelper::getTargets(difficulties.data(), difficulties.size(), targets.data(), targets.size());
+      benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations()*count);
+  }
+  BENCHMARK(BM_GetTargets)->Arg(2048);
+
+  void BM_GetDifficulty(benchmark::State &state)
+  {
+    PoWHelper ph;
+    const auto parent = difficulty(5000000);
+    uint64_t measurement = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(ph.getDifficulty(measurement++%120, parent));
+    }
+  }
+  BENCHMARK(BM_GetDifficulty);
+
+  const char *large_value = "98765432109876543210987654321098765432109876543210987654321098765432109876";
+
+  void BM_StringToUInt256(benchmark::State &state)
+  {
+    const std::string s(large_value);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(StringToUInt256(s));
+    }
+  }
+  BENCHMARK(BM_StringToUInt256);
+
+  void BM_UInt256ToString(benchmark::State &state)
+  {
+    const auto value = StringToUInt256(large_value);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(UInt256ToString(value));
+    }
+  }
+  BENCHMARK(BM_UInt256ToString);
+
+  void BM_UInt256ToChars(benchmark::State &state)
+  {
+    const auto value = StringToUInt256(large_value);
+    char out[UINT256_MAX_DIGITS];
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(UInt256ToChars(value.data(), out));
+      benchmark::ClobberMemory();
+    }
+  }
+  BENCHMARK(BM_UInt256ToChars);
+
+  void BM_ByteVectorRoundTrip(benchmark::State &state)
+  {
+    const auto value = StringToUInt256(large_value);
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(toByteVector(fromByteVector(value)));
+    }
+  }
+  BENCHMARK(BM_ByteVectorRoundTrip);
+
+  void BM_BytesRoundTrip(benchmark::State &state)
+  {
+    const auto value = StringToUInt256(large_value);
+    uint8_t out[32];
+    for (auto _ : state) {
+      toBytes(fromBytes(value.data(), value.size()), out);
+      benchmark::ClobberMemory();
+    }
+  }
+  BENCHMARK(BM_BytesRoundTrip);
+}
@@ -0,0 +1,72 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <pow/targetcache.h>
+#include <misc/bignum.h>
+#include <benchmark/benchmark.h>
+#include <limits>
+#include <random>
+
+namespace {
+  // arg 0: the few difficulties a pool keeps asking for, 1: random 64-bit ones, 2: random 128-bit ones
+  std::vector<u256> difficulties(int64_t set)
+  {
+    std::mt19937_64 rng(9);
+    std::vector<u256> d;
+    for (int i = 0; i<(set==0 ? 8 : 1024); i++) {
+      if (set==0) {
+        d.emplace_back(1000000+i);
+      } else if (set==1) {
+        d.emplace_back(rng() | 1);
+      } else {
+        d.emplace_back(0, 0, rng() | 1, rng());
+      }
+    }
+    return d;
+  }
+
+  void BM_TargetBoost(benchmark::State &state)
+  {
+    const auto d = difficulties(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+      const u256 &v = d[i++ % d.size()];
+      uint256_t divisor = 0;
+      for (int j = 3; j>=0; j--) {
+        divisor = (divisor << 64) | v.limb[j];
+      }
+      benchmark::DoNotOptimize(std::numeric_limits<uint256_t>::max()/divisor);
+    }
+  }
+  BENCHMARK(BM_TargetBoost)->DenseRange(0, 2);
+
+  void BM_TargetKnuth(benchmark::State &state)
+  {
+    const auto d = difficulties(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(u256::max()/d[i++ % d.size()]);
+    }
+  }
+  BENCHMARK(BM_TargetKnuth)->DenseRange(0, 2);
+
+  void BM_TargetReciprocal(benchmark::State &state)
+  {
+    const auto d = difficulties(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(u256::divmodReciprocal(u256::max(), d[i++ % d.size()]));
+    }
+  }
+  BENCHMARK(BM_TargetReciprocal)->DenseRange(0, 2);
+
+  void BM_TargetCached(benchmark::State &state)
+  {
+    const auto d = difficulties(state.range(0));
+    size_t i = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(TargetCache::target(d[i++ % d.size()]));
+    }
+  }
+  BENCHMARK(BM_TargetCached)->DenseRange(0, 2);
+}
@@ -21,6 +21,7 @@
   *
   */
 #include <iostream>
+#include <random>
 #include <qrandomx/qrxminer.h>
 #include <pow/powhelper.h>
 #include <misc/bignum.h>
@@ -93,4 +94,70 @@ namespace {
   TEST(Bignum, bignum_str_invalid) {
     EXPECT_THROW(auto int256 = StringToUInt256("invalid"), std::invalid_argument);
   }
+
+  TEST(Bignum, bignum_buffers) {
+    std::mt19937_64 rng(1);
+    for (int i = 0; i<1000; i++) {
+      std::array<uint8_t, 32> bytes{};
+      for (size_t j = rng()%33; j<32; j++) {
+        bytes[j] = static_cast<uint8_t>(rng());
+      }
+      const uint256_t value = fromByteArray(bytes);
+      const std::vector<uint8_t> vec(bytes.begin(), bytes.end());
+
+      EXPECT_EQ(fromByteVector(vec), value);
+      EXPECT_EQ(bytes, toByteArray(value));
+      EXPECT_EQ(vec, toByteVector(value));
+
+      std::array<uint8_t, 32> out{};
+      toBytes(value, out.data());
+      EXPECT_EQ(bytes, out);
+    }
+    EXPECT_THROW(fromBytes(nullptr, 31), std::invalid_argument);
+  }
+
+  TEST(Bignum, bignum_hex) {
+    const std::vector<uint8_t> bytes {0x00, 0x0F, 0xA0, 0xFF, 0x42};
+    EXPECT_EQ("000fa0ff42", printByteVector2(bytes));
+    EXPECT_EQ("0x00, 0x0f, 0xa0, 0xff, 0x42", printByteVector(bytes));
+    EXPECT_EQ("", printByteVector2({}));
+
+    std::vector<uint8_t> decoded(5);
+    hexDecode("000FA0ff42", 5, decoded.data());
+    EXPECT_EQ(bytes, decoded);
+    EXPECT_THROW(hexDecode("0g", 1, decoded.data()), std::invalid_argument);
+  }
+
+  TEST(Bignum, bignum_decimal) {
+    std::mt19937_64 rng(2);
+    char buffer[UINT256_MAX_DIGITS];
+
+    for (int i = 0; i<1000; i++) {
+      std::vector<uint8_t> bytes(32, 0);
+      for (size_t j = rng()%33; j<32; j++) {
+        bytes[j] = static_cast<uint8_t>(rng());
+      }
+      const std::string expected = fromByteVector(bytes).str();
+
+      EXPECT_EQ(expected, UInt256ToString(bytes));
+      EXPECT_EQ(expected, std::string(buffer, UInt256ToChars(bytes.data(), buffer)));
+      EXPECT_EQ(bytes, StringToUInt256(expected));
+    }
+
+    std::vector<uint8_t> max(32, 0xFF);
+    EXPECT_EQ(UINT256_MAX_DIGITS, UInt256ToString(max).size());
+    EXPECT_EQ("0", UInt256ToString(std::vector<uint8_t>(32)));
+  }
+
+  TEST(Bignum, bignum_str_grammar) {
+    // the formats and the wrap-around the boost parser used to accept
+    for (const std::string s : {"0x1f", "0X1F", "010", "-1", "0x", "00", "18446744073709551616",
+                                "115792089237316195423570985008687907853269984665640564039457584007913129639936"}) {
+      EXPECT_EQ(toByteVector(uint256_t(s)), StringToUInt256(s)) << s;
+    }
+    for (const std::string s : {"09", " 5", "5 ", "+5", "0xg", "1.5"}) {
+      EXPECT_THROW(StringToUInt256(s), std::invalid_argument) << s;
+    }
+  }
 }
+
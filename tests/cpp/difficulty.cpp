@@ -0,0 +1,211 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <cfenv>
+#include <random>
+#include <string>
+#include <pow/powhelper.h>
+#include <misc/bignum.h>
+#include "gtest/gtest.h"
+
+namespace {
+  struct DifficultyVector {
+    int64_t kp;
+    uint64_t set_point;
+    int64_t adjfact_lower;
+    int64_t adjfact_upper;
+    int64_t adj_quantization;
+    uint64_t measurement;
+    int parent;
+    const char *expected;  // hex, big endian
+  };
+
+  const char *parents[] = {
+      "2",
+      "29e7",
+      "f4240",
+      "123456789abcdef0123456789abcdef01",
+      "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe",
+      "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+  };
+
+  // outputs of the floating point implementation this replaced
+  const DifficultyVector corpus[] = {
+      {100, 60, -1000, 1000, 1024, 0, 0, "3"},
+      {100, 60, -1000, 1000, 1024, 0, 1, "2dfe"},
+      {100, 60, -1000, 1000, 1024, 0, 2, "10bfb8"},
+      {100, 60, -1000, 1000, 1024, 0, 3, "13fb72ea61d950b583fb72ea61d950b58"},
+      {100, 60, -1000, 1000, 1024, 0, 4, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 0, 5, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 30, 0, "3"},
+      {100, 60, -1000, 1000, 1024, 30, 1, "2bf2"},
+      {100, 60, -1000, 1000, 1024, 30, 2, "1000fc"},
+      {100, 60, -1000, 1000, 1024, 30, 3, "1317e4b17e4b17d2cb17e4b17e4b17d2c"},
+      {100, 60, -1000, 1000, 1024, 30, 4, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 30, 5, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 60, 0, "2"},
+      {100, 60, -1000, 1000, 1024, 60, 1, "29e7"},
+      {100, 60, -1000, 1000, 1024, 60, 2, "f4240"},
+      {100, 60, -1000, 1000, 1024, 60, 3, "123456789abcdef0123456789abcdef01"},
+      {100, 60, -1000, 1000, 1024, 60, 4, "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffe"},
+      {100, 60, -1000, 1000, 1024, 60, 5, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 61, 0, "2"},
+      {100, 60, -1000, 1000, 1024, 61, 1, "29dd"},
+      {100, 60, -1000, 1000, 1024, 61, 2, "f3e70"},
+      {100, 60, -1000, 1000, 1024, 61, 3, "122fc962fc962fb8562fc962fc962fb86"},
+      {100, 60, -1000, 1000, 1024, 61, 4, "ffbfffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 61, 5, "ffc0000000000000000000000000000000000000000000000000000000000000"},
+      {100, 60, -1000, 1000, 1024, 187, 0, "2"},
+      {100, 60, -1000, 1000, 1024, 187, 1, "2145"},
+      {100, 60, -1000, 1000, 1024, 187, 2, "c1d5a"},
+      {100, 60, -1000, 1000, 1024, 187, 3, "e740da740da74001a740da740da74002"},
+      {100, 60, -1000, 1000, 1024, 187, 4, "cb3fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {100, 60, -1000, 1000, 1024, 187, 5, "cb40000000000000000000000000000000000000000000000000000000000000"},
+      {100, 60, -1000, 1000, 1024, 1000000, 0, "2"},
+      {100, 60, -1000, 1000, 1024, 1000000, 1, "fc"},
+      {100, 60, -1000, 1000, 1024, 1000000, 2, "5b8e"},
+      {100, 60, -1000, 1000, 1024, 1000000, 3, "6d3a06d3a06d39a06d3a06d3a06d39b"},
+      {100, 60, -1000, 1000, 1024, 1000000, 4, "600000000000000000000000000000000000000000000000000000000000000"},
+      {100, 60, -1000, 1000, 1024, 1000000, 5, "600000000000000000000000000000000000000000000000000000000000000"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 0, "2"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 1, "fc"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 2, "5b8e"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 3, "6d3a06d3a06d39a06d3a06d3a06d39b"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 4, "600000000000000000000000000000000000000000000000000000000000000"},
+      {100, 60, -1000, 1000, 1024, UINT64_MAX, 5, "600000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, 0, 0, "3"},
+      {1000, 1, -10000, 10000, 65536, 0, 1, "2a8a"},
+      {1000, 1, -10000, 10000, 65536, 0, 2, "f7dda"},
+      {1000, 1, -10000, 10000, 65536, 0, 3, "127b72ea61d950b6ebfb72ea61d950b6e"},
+      {1000, 1, -10000, 10000, 65536, 0, 4, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 0, 5, "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 30, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, 30, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, 30, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, 30, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, 30, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 30, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, 60, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, 60, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, 60, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, 60, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, 60, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 60, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, 61, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, 61, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, 61, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, 61, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, 61, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 61, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, 187, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, 187, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, 187, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, 187, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, 187, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 187, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, 1000000, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 0, "2"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 1, "2383"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 2, "cee35"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 3, "f6d3a06d3a06d2b906d3a06d3a06d2b9"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 4, "d8efffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"},
+      {1000, 1, -10000, 10000, 65536, UINT64_MAX, 5, "d8f0000000000000000000000000000000000000000000000000000000000000"},
+  };
+
+  std::vector<uint8_t> fromHex(const std::string &hex)
+  {
+    const std::string padded = std::string(64-hex.size(), '0')+hex;
+    std::vector<uint8_t> v(32);
+    for (size_t i = 0; i<32; i++) {
+      v[i] = static_cast<uint8_t>(std::stoul(padded.substr(i*2, 2), nullptr, 16));
+    }
+    return v;
+  }
+
+  // the floating point implementation, kept as a reference
+  std::vector<uint8_t> legacyDifficulty(int64_t kp, uint64_t set_point,
+                                        int64_t adjfact_lower, int64_t adjfact_upper,
+                                        int64_t adj_quantization,
+                                        uint64_t measurement,
+                                        const std::vector<uint8_t> &parent_difficulty_vec)
+  {
+    const uint256_t difficulty_lower_bound = 2;
+    const uint256_t difficulty_upper_bound = std::numeric_limits<uint256_t>::max();
+
+    const auto tmp_val = static_cast<long>(((double) kp) - (double)kp*(double)measurement/(double)set_point);
+    bigint adjustment = bigint(tmp_val);
+    if (adjustment > adjfact_upper) {
+      adjustment = bigint(adjfact_upper);
+    }
+    if (adjustment < adjfact_lower) {
+      adjustment = bigint(adjfact_lower);
+    }
+
+    uint256_t parent_difficulty = fromByteVector(parent_difficulty_vec);
+    bigint difficulty_delta = (parent_difficulty * adjustment) / adj_quantization;
+    if (difficulty_delta == 0 && adjustment != 0) {
+      difficulty_delta = adjustment < 0 ? -1 : 1;
+    }
+
+    bigint difficulty = parent_difficulty + difficulty_delta;
+    difficulty = std::max<bigint>(difficulty, difficulty_lower_bound);
+    difficulty = std::min<bigint>(difficulty, difficulty_upper_bound);
+    return toByteVector(uint256_t(difficulty));
+  }
+
+  void checkCorpus()
+  {
+    for (const auto &v : corpus) {
+      PoWHelper ph(v.kp, v.set_point, v.adjfact_lower, v.adjfact_upper, v.adj_quantization);
+      ASSERT_EQ(fromHex(v.expected), ph.getDifficulty(v.measurement, fromHex(parents[v.parent])))
+        << v.kp << " " << v.measurement << " " << parents[v.parent];
+    }
+  }
+
+  TEST(Difficulty, Corpus) {
+    checkCorpus();
+  }
+
+  TEST(Difficulty, IndependentOfRoundingMode) {
+    for (int mode : {FE_UPWARD, FE_DOWNWARD, FE_TOWARDZERO}) {
+      std::fesetround(mode);
+      checkCorpus();
+    }
+    std::fesetround(FE_TONEAREST);
+  }
+
+  TEST(Difficulty, MatchesLegacy) {
+    std::mt19937_64 rng(5);
+
+    for (int i = 0; i<20000; i++) {
+      const int64_t kp = static_cast<int64_t>(rng()%2000);
+      const uint64_t set_point = 1+rng()%600;
+      const int64_t adjfact_lower = -static_cast<int64_t>(rng()%100000);
+      const int64_t adjfact_upper = static_cast<int64_t>(rng()%100000);
+      const int64_t adj_quantization = 1+static_cast<int64_t>(rng()%100000);
+      const uint64_t measurement = rng()%(set_point*20);
+
+      std::vector<uint8_t> parent(32, 0);
+      const int bytes = 1+static_cast<int>(rng()%32);
+      for (int j = 32-bytes; j<32; j++) {
+        parent[j] = static_cast<uint8_t>(rng());
+      }
+
+      PoWHelper ph(kp, set_point, adjfact_lower, adjfact_upper, adj_quantization);
+      ASSERT_EQ(legacyDifficulty(kp, set_point, adjfact_lower, adjfact_upper, adj_quantization, measurement, parent),
+                ph.getDifficulty(measurement, parent)) << i;
+    }
+  }
+
+  TEST(Difficulty, InvalidInput) {
+    PoWHelper ph;
+    EXPECT_THROW(ph.getDifficulty(60, std::vector<uint8_t>(31)), std::invalid_argument);
+
+    PoWHelper no_set_point(100, 0);
+    EXPECT_THROW(no_set_point.getDifficulty(60, std::vector<uint8_t>(32)), std::invalid_argument);
+  }
+}
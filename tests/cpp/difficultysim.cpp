@@ -0,0 +1,95 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <pow/difficultysim.h>
+#include <pow/powhelper.h>
+#include <misc/bignum.h>
+#include "gtest/gtest.h"
+
+namespace {
+  TEST(DifficultySimulator, ReplayMatchesController) {
+    std::vector<uint64_t> timestamps {0};
+    for (uint64_t i = 0; i<500; i++) {
+      timestamps.push_back(timestamps.back()+(i%7)*20);
+    }
+
+    DifficultySimConfig config;
+    config.initialDifficulty = 50000;
+
+    DifficultySimParams params(150, 60, -500, 500, 2048);
+    auto stats = DifficultySimulator::replay({params, params}, timestamps, config);
+    ASSERT_EQ(2, stats.size());
+
+    PoWHelper ph(150, 60, -500, 500, 2048);
+    auto difficulty = toByteVector(50000);
+    for (size_t i = 1; i<timestamps.size(); i++) {
+      difficulty = ph.getDifficulty(timestamps[i]-timestamps[i-1], difficulty);
+    }
+
+    EXPECT_EQ(500, stats[0].blocks);
+    EXPECT_EQ(static_cast<double>(fromByteVector(difficulty)), stats[0].finalDifficulty);
+    EXPECT_NEAR((timestamps.back()-timestamps.front())/500.0, stats[0].meanBlockTime, 1e-9);
+    EXPECT_GT(stats[0].oscillations, 0);
+    EXPECT_EQ(stats[0].finalDifficulty, stats[1].finalDifficulty);
+  }
+
+  TEST(DifficultySimulator, ReplaySteady) {
+    std::vector<uint64_t> timestamps;
+    for (uint64_t i = 0; i<=300; i++) {
+      timestamps.push_back(1000+i*60);
+    }
+
+    DifficultySimConfig config;
+    config.window = 10;
+    auto stats = DifficultySimulator::replay({DifficultySimParams()}, timestamps, config);
+
+    EXPECT_EQ(1000, stats[0].finalDifficulty);
+    EXPECT_EQ(0, stats[0].difficultyStdDev);
+    EXPECT_EQ(0, stats[0].oscillations);
+    EXPECT_EQ(9, stats[0].convergenceBlock);
+
+    EXPECT_EQ(0, DifficultySimulator::replay({DifficultySimParams()}, {}, config)[0].blocks);
+  }
+
+  TEST(DifficultySimulator, SimulateConverges) {
+    DifficultySimConfig config;
+    config.blocks = 20000;
+    config.initialDifficulty = 1000;
+    config.hashrate = 100;
+    config.hashrateChangeBlock = 10000;
+    config.hashrateChangeFactor = 2;
+
+    std::vector<DifficultySimParams> params {
+      DifficultySimParams(),
+      DifficultySimParams(20),
+      DifficultySimParams(),
+    };
+
+    auto stats = DifficultySimulator::simulate(params, config, 4);
+    ASSERT_EQ(3, stats.size());
+
+    for (const auto &s: stats) {
+      EXPECT_NEAR(60, s.meanBlockTime, 6);
+      EXPECT_GT(s.blockTimeStdDev, 0);
+      EXPECT_GT(s.convergenceBlock, 0);
+      // twice the hashrate settles at twice the difficulty, 12000
+      EXPECT_GT(s.finalDifficulty, 6000);
+      EXPECT_LT(s.finalDifficulty, 24000);
+    }
+
+    // a weaker controller reacts slower and swings less
+    EXPECT_LT(stats[1].oscillations, stats[0].oscillations);
+
+    // deterministic for a given seed, whatever the thread count
+    auto single = DifficultySimulator::simulate({DifficultySimParams()}, config, 1);
+    EXPECT_EQ(single[0].finalDifficulty, stats[0].finalDifficulty);
+    EXPECT_EQ(single[0].oscillations, stats[2].oscillations);
+
+    config.hashrate = 0;
+    EXPECT_THROW(DifficultySimulator::simulate(params, config), std::invalid_argument);
+
+    config.hashrate = 1000;
+    EXPECT_THROW(DifficultySimulator::simulate({DifficultySimParams(100, 0)}, config), std::invalid_argument);
+    EXPECT_THROW(DifficultySimulator::replay({DifficultySimParams(100, 60, -1000, 1000, 0)}, {0, 60}, config),
+                 std::invalid_argument);
+  }
+}
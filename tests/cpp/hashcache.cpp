@@ -0,0 +1,114 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <thread>
+#include <pow/hashcache.h>
+#include <pow/powhelper.h>
+#include "gtest/gtest.h"
+
+namespace {
+  std::vector<uint8_t> makeInput(uint32_t i)
+  {
+    std::vector<uint8_t> input(76, 0x11);
+    input[39] = static_cast<uint8_t>(i);
+    input[40] = static_cast<uint8_t>(i >> 8);
+    return input;
+  }
+
+  TEST(HashCache, HitAndMiss) {
+    HashCache cache(1 << 20);
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> hash(32, 0x55);
+    std::vector<uint8_t> output;
+
+    EXPECT_FALSE(cache.get(seed_hash, makeInput(1), output));
+    cache.put(seed_hash, makeInput(1), hash);
+    ASSERT_TRUE(cache.get(seed_hash, makeInput(1), output));
+    EXPECT_EQ(hash, output);
+
+    // the seed is part of the key
+    EXPECT_FALSE(cache.get(std::vector<uint8_t>(32, 0x2b), makeInput(1), output));
+    EXPECT_FALSE(cache.get(seed_hash, makeInput(2), output));
+
+    EXPECT_EQ(1, cache.hits());
+    EXPECT_EQ(3, cache.misses());
+    EXPECT_EQ(1, cache.entries());
+
+    // replacing keeps a single entry
+    cache.put(seed_hash, makeInput(1), std::vector<uint8_t>(32, 0x66));
+    ASSERT_TRUE(cache.get(seed_hash, makeInput(1), output));
+    EXPECT_EQ(std::vector<uint8_t>(32, 0x66), output);
+    EXPECT_EQ(1, cache.entries());
+  }
+
+  TEST(HashCache, ByteLimitEvictsLeastRecentlyUsed) {
+    // a single shard makes the eviction order predictable
+    HashCache cache(4096, 1);
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> output;
+
+    for (uint32_t i = 0; i<1000; i++) {
+      cache.put(seed_hash, makeInput(i), std::vector<uint8_t>(32, static_cast<uint8_t>(i)));
+      // keep the first one in use
+      ASSERT_TRUE(cache.get(seed_hash, makeInput(0), output));
+      EXPECT_LE(cache.bytes(), cache.maxBytes());
+    }
+
+    EXPECT_GT(cache.entries(), 1);
+    EXPECT_LT(cache.entries(), 1000);
+    EXPECT_TRUE(cache.get(seed_hash, makeInput(999), output));
+    EXPECT_EQ(std::vector<uint8_t>(32, static_cast<uint8_t>(999)), output);
+    EXPECT_FALSE(cache.get(seed_hash, makeInput(1), output));
+  }
+
+  TEST(HashCache, Concurrent) {
+    HashCache cache(1 << 16);
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t<4; t++) {
+      threads.emplace_back([&, t]() {
+        std::vector<uint8_t> output;
+        for (uint32_t i = 0; i<2000; i++) {
+          const uint32_t n = (i*7+t)%300;
+          if (cache.get(seed_hash, makeInput(n), output)) {
+            ASSERT_EQ(std::vector<uint8_t>(32, static_cast<uint8_t>(n)), output);
+          } else {
+            cache.put(seed_hash, makeInput(n), std::vector<uint8_t>(32, static_cast<uint8_t>(n)));
+          }
+        }
+      });
+    }
+    for (auto &thread: threads) {
+      thread.join();
+    }
+
+    EXPECT_EQ(8000, cache.hits()+cache.misses());
+    EXPECT_LE(cache.bytes(), cache.maxBytes());
+  }
+
+  TEST(HashCache, PoWHelperVerify) {
+    PoWHelper ph;
+    ph.setHashCacheSize(1 << 20);
+
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> target(32, 0xFF);
+
+    const bool expected = ph.verifyInput(10, 0, seed_hash, makeInput(1), target);
+    EXPECT_EQ(expected, ph.verifyInput(10, 0, seed_hash, makeInput(1), target));
+    EXPECT_EQ(1, ph.hashCacheStats().hits);
+    EXPECT_EQ(1, ph.hashCacheStats().misses);
+    EXPECT_EQ(1, ph.hashCacheStats().entries);
+
+    // the batch path shares the cache
+    std::vector<PoWVerifyItem> items;
+    items.emplace_back(10, 0, seed_hash, makeInput(1), target);
+    items.emplace_back(10, 0, seed_hash, makeInput(2), target);
+    auto results = ph.verifyInputs(items);
+    EXPECT_EQ(expected, results[0] != 0);
+    EXPECT_EQ(2, ph.hashCacheStats().hits);
+    EXPECT_EQ(2, ph.hashCacheStats().entries);
+
+    ph.setHashCacheSize(0);
+    EXPECT_EQ(0, ph.hashCacheStats().maxBytes);
+  }
+}
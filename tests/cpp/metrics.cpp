@@ -0,0 +1,86 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <misc/metrics.h>
+#include <qrandomx/qrandomx.h>
+#include "gtest/gtest.h"
+#include <thread>
+
+namespace {
+  TEST(Metrics, Registry) {
+    auto &m = Metrics::instance();
+    auto &a = m.counter("qrandomx_test_events_total", "Test events", "kind=\"a\"");
+    auto &b = m.counter("qrandomx_test_events_total", "Test events", "kind=\"b\"");
+    EXPECT_NE(&a, &b);
+    EXPECT_EQ(&a, &m.counter("qrandomx_test_events_total", "Test events", "kind=\"a\""));
+    EXPECT_THROW(m.gauge("qrandomx_test_events_total", "Test events"), std::invalid_argument);
+
+    const auto before = a.value();
+    std::vector<std::thread> threads;
+    for (int t = 0; t<4; t++) {
+      threads.emplace_back([&]() {
+        for (int i = 0; i<1000; i++) {
+          a.inc();
+        }
+      });
+    }
+    for (auto &t: threads) {
+      t.join();
+    }
+    EXPECT_EQ(before+4000, a.value());
+
+    auto &g = m.gauge("qrandomx_test_level", "Test level");
+    g.set(5);
+    g.add(-7);
+    EXPECT_EQ(-2, g.value());
+  }
+
+  TEST(Metrics, Histogram) {
+    MetricHistogram h({1, 2, 5});
+    for (double v: {0.5, 1.0, 1.5, 4.0, 7.0, 9.0}) {
+      h.observe(v);
+    }
+    EXPECT_EQ(std::vector<uint64_t>({2, 1, 1, 2}), h.bucketCounts());
+    EXPECT_EQ(6u, h.count());
+    EXPECT_DOUBLE_EQ(23.0, h.sum());
+    EXPECT_THROW(MetricHistogram({2, 1}), std::invalid_argument);
+  }
+
+  TEST(Metrics, PrometheusText) {
+    auto &h = Metrics::instance().histogram("qrandomx_test_duration_seconds", "Test\nduration", {0.5, 1});
+    h.observe(0.25);
+    h.observe(0.75);
+    h.observe(3);
+
+    const auto text = PrometheusMetrics();
+    EXPECT_NE(std::string::npos, text.find("# HELP qrandomx_test_duration_seconds Test\\nduration\n"
+                                           "# TYPE qrandomx_test_duration_seconds histogram\n"
+                                           "qrandomx_test_duration_seconds_bucket{le=\"0.5\"} 1\n"
+                                           "qrandomx_test_duration_seconds_bucket{le=\"1\"} 2\n"
+                                           "qrandomx_test_duration_seconds_bucket{le=\"+Inf\"} 3\n"
+                                           "qrandomx_test_duration_seconds_sum 4\n"
+                                           "qrandomx_test_duration_seconds_count 3\n"));
+    EXPECT_NE(std::string::npos, text.find("# TYPE qrandomx_test_events_total counter\n"
+                                           "qrandomx_test_events_total{kind=\"a\"} "));
+  }
+
+  TEST(Metrics, HashMetrics) {
+    auto &hashes = Metrics::instance().counter("qrandomx_hashes_total", "RandomX hashes computed",
+                                               "path=\"slow_hash\"");
+    auto &misses = Metrics::instance().counter("qrandomx_seed_cache_misses_total",
+                                               "Hashes that had to rebuild the cache for their seed");
+    const auto hashes_before = hashes.value();
+    const auto misses_before = misses.value();
+
+    QRandomX::hash(10, 0, std::vector<uint8_t>(32, 0x6e), std::vector<uint8_t>(76), 0);
+    QRandomX::hash(10, 0, std::vector<uint8_t>(32, 0x6e), std::vector<uint8_t>(76), 0);
+
+    EXPECT_EQ(hashes_before+2, hashes.value());
+    EXPECT_EQ(misses_before+1, misses.value());
+
+    const auto text = PrometheusMetrics();
+    EXPECT_NE(std::string::npos, text.find("# TYPE qrandomx_hash_duration_seconds histogram\n"));
+    EXPECT_NE(std::string::npos, text.find("qrandomx_seed_cache_hits_total "));
+    EXPECT_NE(std::string::npos, text.find("qrandomx_large_page_allocations_total{allocation=\"cache\""));
+  }
+}
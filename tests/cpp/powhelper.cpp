@@ -43,6 +43,7 @@ inline uint32_t get_fp_status() {
 #include <qrandomx/qrxminer.h>
 #include <pow/powhelper.h>
 #include <misc/bignum.h>
+#include <qrandomx/qrandomx.h>
 #include "gtest/gtest.h"
 
 namespace {
@@ -249,4 +250,203 @@ namespace {
 
     CHECK_FP_STATE();
   }
-}
\ No newline at end of file
+
+  TEST(PoWHelper, BatchTargets) {
+    PoWHelper ph;
+
+    const size_t count = 19;
+    std::vector<uint8_t> difficulties(count*32, 0);
+    std::vector<uint8_t> hashes(count*32, 0);
+    for (size_t i = 0; i<count; i++) {
+      auto difficulty = toByteVector(1000 + i*997);
+      std::copy(difficulty.begin(), difficulty.end(), difficulties.begin()+i*32);
+      for (size_t j = 0; j<32; j++) {
+        hashes[i*32+j] = static_cast<uint8_t>(i*31+j*7);
+      }
+      // little endian: keep the top byte clear so roughly half of them pass
+      hashes[i*32+31] = 0;
+      hashes[i*32+30] = static_cast<uint8_t>(i*7);
+    }
+
+    std::vector<uint8_t> targets(count*32);
+    PoWHelper::getTargets(difficulties.data(), difficulties.size(), targets.data(), targets.size());
+
+    std::vector<uint8_t> bitmap_targets((count+7)/8, 0xFF);
+    std::vector<uint8_t> bitmap_difficulties((count+7)/8, 0xFF);
+    PoWHelper::passesTargets(hashes.data(), hashes.size(), targets.data(), targets.size(),
+                             bitmap_targets.data(), bitmap_targets.size());
+    PoWHelper::passesDifficulties(hashes.data(), hashes.size(), difficulties.data(), difficulties.size(),
+                                  bitmap_difficulties.data(), bitmap_difficulties.size());
+    EXPECT_EQ(bitmap_targets, bitmap_difficulties);
+
+    int passed = 0;
+    for (size_t i = 0; i<count; i++) {
+      std::vector<uint8_t> difficulty(difficulties.begin()+i*32, difficulties.begin()+(i+1)*32);
+      std::vector<uint8_t> hash(hashes.begin()+i*32, hashes.begin()+(i+1)*32);
+      auto target = ph.getTarget(difficulty);
+
+      EXPECT_EQ(target, std::vector<uint8_t>(targets.begin()+i*32, targets.begin()+(i+1)*32));
+      const bool expected = PoWHelper::passesTarget(hash, target);
+      EXPECT_EQ(expected, (bitmap_targets[i/8] >> (i%8)) & 1);
+      passed += expected;
+    }
+    EXPECT_GT(passed, 0);
+    EXPECT_LT(passed, count);
+
+    // bits past the last hash are cleared
+    EXPECT_EQ(0, bitmap_targets.back() >> (count%8));
+    CHECK_FP_STATE();
+  }
+
+  TEST(PoWHelper, BatchSharedTarget) {
+    std::vector<uint8_t> target(32, 0);
+    target[31] = 0x10;
+
+    std::vector<uint8_t> hashes(3*32, 0);
+    hashes[31] = 0x0F;        // below
+    hashes[32+31] = 0x10;     // equal
+    hashes[64+31] = 0x11;     // above
+
+    std::vector<uint8_t> bitmap(1);
+    PoWHelper::passesTargets(hashes.data(), hashes.size(), target.data(), target.size(),
+                             bitmap.data(), bitmap.size());
+    EXPECT_EQ(0x03, bitmap[0]);
+
+    EXPECT_THROW(PoWHelper::passesTargets(hashes.data(), 33, target.data(), target.size(),
+                                          bitmap.data(), bitmap.size()), std::invalid_argument);
+    EXPECT_THROW(PoWHelper::passesTargets(hashes.data(), hashes.size(), target.data(), 64,
+                                          bitmap.data(), bitmap.size()), std::invalid_argument);
+    EXPECT_THROW(PoWHelper::passesTargets(hashes.data(), hashes.size(), target.data(), target.size(),
+                                          bitmap.data(), 0), std::invalid_argument);
+    CHECK_FP_STATE();
+  }
+
+  TEST(PoWHelper, VerifyInputs) {
+    PoWHelper ph;
+
+    const uint64_t main_height = 10;
+    const uint64_t seed_height = QRandomX::getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash {
+      0x2a, 0x1c, 0x03, 0x5a, 0x8a, 0x5b, 0x4c, 0x38, 0x26, 0x0f, 0x2a, 0x13, 0x55, 0x03, 0x4a, 0x05,
+      0x1e, 0x2c, 0x3b, 0x0c, 0x4d, 0x5e, 0x6f, 0x70, 0x81, 0x92, 0xa3, 0xb4, 0xc5, 0xd6, 0xe7, 0xf8
+    };
+    std::vector<uint8_t> other_seed_hash(seed_hash.rbegin(), seed_hash.rend());
+
+    // make seed_hash the mainchain seed so both paths are taken
+    QRandomX::hash(main_height, seed_height, seed_hash, {0x01}, 0);
+
+    // roughly half of the hashes pass
+    std::vector<uint8_t> target(32, 0xFF);
+    target[31] = 0x7F;
+
+    std::vector<PoWVerifyItem> items;
+    for (uint8_t i = 0; i<12; i++) {
+      std::vector<uint8_t> input(76, i);
+      items.emplace_back(main_height, seed_height, i%3==0 ? other_seed_hash : seed_hash, input, target);
+    }
+    items.emplace_back(main_height, seed_height, seed_hash, std::vector<uint8_t>(76), std::vector<uint8_t>(31));
+
+    auto results = ph.verifyInputs(items, 4);
+    ASSERT_EQ(items.size(), results.size());
+
+    int passed = 0;
+    for (size_t i = 0; i<items.size()-1; i++) {
+      const auto &item = items[i];
+      EXPECT_EQ(ph.verifyInput(item.mainHeight, item.seedHeight, item.seedHash, item.input, item.target),
+                results[i] != 0) << i;
+      passed += results[i];
+    }
+    EXPECT_GT(passed, 0);
+    EXPECT_LT(passed, 12);
+    EXPECT_EQ(0, results.back());
+
+    // a single thread gives the same results
+    EXPECT_EQ(results, ph.verifyInputs(items, 1));
+    EXPECT_TRUE(ph.verifyInputs({}).empty());
+    CHECK_FP_STATE();
+  }
+
+  TEST(PoWHelper, HashBatch) {
+    const uint64_t main_height = 10;
+    const uint64_t seed_height = QRandomX::getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash(32, 0x3c);
+    std::vector<uint8_t> other_seed_hash(32, 0xc3);
+
+    // seed_hash is the mainchain seed, other_seed_hash goes through the batch cache
+    QRandomX::hash(main_height, seed_height, seed_hash, {0x01}, 0);
+
+    const size_t count = 9;
+    const size_t input_size = 76;
+    std::vector<uint8_t> inputs(count*input_size);
+    for (size_t i = 0; i<inputs.size(); i++) {
+      inputs[i] = static_cast<uint8_t>(i*13);
+    }
+
+    for (const auto &seed: {seed_hash, other_seed_hash}) {
+      std::vector<uint8_t> outputs(count*32);
+      PoWHelper::hashBatch(main_height, seed_height, seed.data(), seed.size(),
+                           inputs.data(), inputs.size(), input_size,
+                           outputs.data(), outputs.size(), 4);
+
+      for (size_t i = 0; i<count; i++) {
+        std::vector<uint8_t> input(inputs.begin()+i*input_size, inputs.begin()+(i+1)*input_size);
+        EXPECT_EQ(QRandomX::hash(main_height, seed_height, seed, input, 0, 1),
+                  std::vector<uint8_t>(outputs.begin()+i*32, outputs.begin()+(i+1)*32)) << i;
+      }
+    }
+
+    std::vector<uint8_t> outputs(count*32);
+    EXPECT_THROW(PoWHelper::hashBatch(main_height, seed_height, seed_hash.data(), 31,
+                                      inputs.data(), inputs.size(), input_size,
+                                      outputs.data(), outputs.size()), std::invalid_argument);
+    EXPECT_THROW(PoWHelper::hashBatch(main_height, seed_height, seed_hash.data(), 32,
+                                      inputs.data(), inputs.size(), 75,
+                                      outputs.data(), outputs.size()), std::invalid_argument);
+    EXPECT_THROW(PoWHelper::hashBatch(main_height, seed_height, seed_hash.data(), 32,
+                                      inputs.data(), inputs.size(), input_size,
+                                      outputs.data(), outputs.size()-1), std::invalid_argument);
+    CHECK_FP_STATE();
+  }
+
+  TEST(PoWHelper, PrecheckInput) {
+    PoWHelper ph;
+
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> input(76, 0x01);
+    std::vector<uint8_t> target(32, 0);
+    target[0] = 0x01;
+
+    EXPECT_EQ(PRECHECK_OK, ph.precheckInput(seed_hash, input, target));
+    EXPECT_EQ(PRECHECK_BAD_TARGET, ph.precheckInput(seed_hash, input, std::vector<uint8_t>(32)));
+    EXPECT_EQ(PRECHECK_BAD_TARGET, ph.precheckInput(seed_hash, input, std::vector<uint8_t>(31, 0xFF)));
+    EXPECT_EQ(PRECHECK_BAD_SEED, ph.precheckInput(std::vector<uint8_t>(31), input, target));
+
+    ph.setInputLength(76, 76);
+    EXPECT_EQ(PRECHECK_OK, ph.precheckInput(seed_hash, input, target));
+    EXPECT_EQ(PRECHECK_BAD_LENGTH, ph.precheckInput(seed_hash, std::vector<uint8_t>(75), target));
+    EXPECT_EQ(PRECHECK_BAD_LENGTH, ph.precheckInput(seed_hash, std::vector<uint8_t>(77), target));
+    EXPECT_THROW(ph.setInputLength(2, 1), std::invalid_argument);
+
+    ph.setNonceOffset(72);
+    EXPECT_EQ(PRECHECK_OK, ph.precheckInput(seed_hash, input, target));
+    ph.setNonceOffset(73);
+    EXPECT_EQ(PRECHECK_BAD_NONCE_OFFSET, ph.precheckInput(seed_hash, input, target));
+    ph.setNonceOffset(39);
+    ph.setInputLength(0, 1000);
+    EXPECT_EQ(PRECHECK_BAD_NONCE_OFFSET, ph.precheckInput(seed_hash, std::vector<uint8_t>(2), target));
+
+    // practically nothing meets this target, the rejection is remembered
+    EXPECT_FALSE(ph.verifyInput(10, 0, seed_hash, input, target));
+    EXPECT_EQ(PRECHECK_DUPLICATE, ph.precheckInput(seed_hash, input, target));
+    EXPECT_FALSE(ph.verifyInput(10, 0, seed_hash, input, target));
+
+    // the same input against another target was not rejected
+    auto other_target = target;
+    other_target[1] = 0x01;
+    EXPECT_EQ(PRECHECK_OK, ph.precheckInput(seed_hash, input, other_target));
+
+    ph.setDuplicateCacheSize(0);
+    EXPECT_EQ(PRECHECK_OK, ph.precheckInput(seed_hash, input, target));
+    CHECK_FP_STATE();
+  }
+}
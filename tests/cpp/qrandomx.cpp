@@ -41,6 +41,10 @@ inline uint32_t get_fp_status() {
                          ASSERT_LE(_mm_getcsr(), MAXEXPECTEDMXCSR)
 #endif
 #include <qrandomx/qrandomx.h>
+#include <qrandomx/threadedqrandomx.h>
+#include <qrandomx/largepages.h>
+#include <qrandomx/randomxflags.h>
+#include <stdexcept>
 #include <misc/bignum.h>
 #include "gtest/gtest.h"
 
@@ -141,4 +145,116 @@ namespace {
     EXPECT_EQ(output_expected, output);
   }
 
-}
\ No newline at end of file
+  TEST_F(QRandomXTest, ThreadedHashInto) {
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> input(76);
+    for (size_t i = 0; i < input.size(); i++) {
+      input[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    auto expected = qrx.hash(main_height, seed_height, seed_hash, input, 0);
+
+    // a larger buffer gets the hash in its first 32 bytes, the rest is untouched
+    std::vector<uint8_t> output(40, 0xEE);
+    qrx.hashInto(main_height, seed_height, seed_hash.data(), seed_hash.size(),
+                 input.data(), input.size(), output.data(), output.size(), 0);
+    CHECK_FP_STATE();
+
+    EXPECT_EQ(expected, std::vector<uint8_t>(output.begin(), output.begin() + 32));
+    EXPECT_EQ(std::vector<uint8_t>(8, 0xEE), std::vector<uint8_t>(output.begin() + 32, output.end()));
+
+    EXPECT_THROW(qrx.hashInto(main_height, seed_height, seed_hash.data(), 31,
+                              input.data(), input.size(), output.data(), output.size(), 0),
+                 std::invalid_argument);
+    EXPECT_THROW(qrx.hashInto(main_height, seed_height, seed_hash.data(), seed_hash.size(),
+                              input.data(), input.size(), output.data(), 31, 0),
+                 std::invalid_argument);
+  }
+
+  TEST_F(QRandomXTest, LastPhaseTimes) {
+    const uint64_t main_height = 10;
+    const uint64_t seed_height = QRandomX::getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash(32, 0x5d);
+    std::vector<uint8_t> input(76);
+
+    QRandomX qrx;
+    qrx.freeVM();
+
+    // a new seed and no VM on this thread yet
+    qrx.hash(main_height, seed_height, seed_hash, input, 0);
+    auto times = QRandomX::lastPhaseTimes();
+    EXPECT_GT(times.cacheInitNs, 0u);
+    EXPECT_GT(times.vmCreateNs, 0u);
+    EXPECT_EQ(0u, times.datasetInitNs);
+
+    qrx.hash(main_height, seed_height, seed_hash, input, 0);
+    times = QRandomX::lastPhaseTimes();
+    EXPECT_EQ(0u, times.cacheInitNs);
+    EXPECT_EQ(0u, times.vmCreateNs);
+    EXPECT_EQ(0u, times.datasetInitNs);
+    CHECK_FP_STATE();
+  }
+
+
+  TEST_F(QRandomXTest, LargePagesPolicy) {
+    EXPECT_EQ(LARGE_PAGES_PREFER, LargePages::policy(ALLOCATION_VM));
+    EXPECT_THROW(LargePages::setPolicy(static_cast<RandomXAllocation>(3), LARGE_PAGES_OFF), std::invalid_argument);
+    EXPECT_THROW(LargePages::setPolicy(ALLOCATION_VM, static_cast<LargePagesPolicy>(3)), std::invalid_argument);
+
+    LargePages::preallocate(false);
+    EXPECT_NE(PAGES_UNALLOCATED, LargePages::status().cache);
+
+    // off never asks for large pages
+    LargePages::setPolicy(ALLOCATION_VM, LARGE_PAGES_OFF);
+    EXPECT_EQ(LARGE_PAGES_OFF, LargePages::policy(ALLOCATION_VM));
+    QRandomX qrx;
+    qrx.freeVM();
+    const uint64_t main_height = 10;
+    qrx.hash(main_height, QRandomX::getSeedHeight(main_height), std::vector<uint8_t>(32, 0x4c), std::vector<uint8_t>(76), 0);
+    EXPECT_EQ(PAGES_NORMAL, LargePages::status().vm);
+    qrx.freeVM();
+
+    LargePages::setPolicy(LARGE_PAGES_PREFER);
+    EXPECT_EQ(LARGE_PAGES_PREFER, LargePages::policy(ALLOCATION_VM));
+    CHECK_FP_STATE();
+  }
+
+
+  TEST_F(QRandomXTest, FlagsOverride) {
+    const uint64_t main_height = 10;
+    const uint64_t seed_height = QRandomX::getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash(32, 0x3e);
+    std::vector<uint8_t> input(76, 0x11);
+
+    auto info = RandomXFlags::get();
+    EXPECT_EQ((info.detected | info.forced) & ~info.masked, info.effective);
+    EXPECT_EQ("hard_aes jit", RandomXFlags::describe(FLAG_JIT | FLAG_HARD_AES));
+
+    EXPECT_THROW(RandomXFlags::setOverride(0, 1u << 20), std::invalid_argument);
+    EXPECT_THROW(RandomXFlags::setOverride(FLAG_LARGE_PAGES, 0), std::invalid_argument);
+    EXPECT_THROW(RandomXFlags::setOverride(FLAG_FULL_MEM, 0), std::invalid_argument);
+    EXPECT_THROW(RandomXFlags::setOverride(FLAG_SECURE, FLAG_SECURE), std::invalid_argument);
+
+    QRandomX qrx;
+    const auto expected = qrx.hash(main_height, seed_height, seed_hash, input, 0);
+
+    // the interpreter has to give the same hashes, on a VM recreated for the new flags
+    RandomXFlags::setOverride(0, FLAG_JIT);
+    EXPECT_EQ(0u, RandomXFlags::get().effective & FLAG_JIT);
+    EXPECT_EQ(expected, qrx.hash(main_height, seed_height, seed_hash, input, 0));
+    EXPECT_EQ(0u, RandomXFlags::get().lastVm & FLAG_JIT);
+    EXPECT_GT(QRandomX::lastPhaseTimes().vmCreateNs, 0u);
+
+    RandomXFlags::resetOverride();
+    EXPECT_EQ(info.effective, RandomXFlags::get().effective);
+    EXPECT_EQ(expected, qrx.hash(main_height, seed_height, seed_hash, input, 0));
+    EXPECT_EQ(info.effective & FLAG_JIT, RandomXFlags::get().lastVm & FLAG_JIT);
+    qrx.freeVM();
+    CHECK_FP_STATE();
+  }
+
+}
@@ -41,10 +41,12 @@ inline uint32_t get_fp_status() {
                          ASSERT_LE(_mm_getcsr(), MAXEXPECTEDMXCSR)
 #endif
 #include <qrandomx/qrxminer.h>
+#include <qrandomx/qrandomx.h>
 #include <misc/bignum.h>
 #include <pow/powhelper.h>
 #include <qrandomx/threadedqrandomx.h>
 #include "gtest/gtest.h"
+#include <poll.h>
 
 
 namespace {
@@ -445,4 +447,269 @@ namespace {
     CHECK_FP_STATE();
   }
 
-}
\ No newline at end of file
+  TEST(QRXMiner, WaitForEvent)
+  {
+    QRXMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+
+    std::vector<uint8_t> easy_target = {
+            0x9F, 0xFF, 0xFF, 0xE1, 0xAC, 0xF3, 0x55, 0x92,
+            0x66, 0xD8, 0x43, 0x89, 0xCE, 0xDE, 0x99, 0x33,
+            0xC6, 0x8F, 0xC5, 0x1E, 0xD0, 0xA6, 0xC7, 0x91,
+            0xF8, 0xF9, 0xE8, 0x9D, 0xB6, 0x23, 0xF0, 0xFF
+    };
+
+    std::vector<uint8_t> impossible_target(32, 0);
+
+    qm.start(main_height, seed_height, seed_hash, input, 0, easy_target);
+    EXPECT_EQ(WAIT_SOLUTION, qm.waitForEvent(60000));
+    ASSERT_TRUE(qm.solutionAvailable());
+
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target);
+    auto before = std::chrono::steady_clock::now();
+    EXPECT_EQ(WAIT_TIMEOUT, qm.waitForEvent(50));
+    EXPECT_LT(std::chrono::steady_clock::now() - before, std::chrono::seconds(1));
+
+    std::thread canceller([&]() {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(200ms);
+      qm.cancel();
+    });
+    EXPECT_EQ(WAIT_CANCELLED, qm.waitForEvent(60000));
+    canceller.join();
+
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target);
+    qm.setTimer(100);
+    EXPECT_EQ(WAIT_DEADLINE, qm.waitForEvent(60000));
+    EXPECT_FALSE(qm.solutionAvailable());
+    CHECK_FP_STATE();
+  }
+
+  TEST(QRXMiner, EventPolling)
+  {
+    class CountingMiner : public QRXMiner {
+    public:
+      uint8_t handleEvent(MinerEvent /*event*/) override
+      {
+        handled++;
+        return 1;
+      }
+      std::atomic<uint32_t> handled{0};
+    };
+
+    CountingMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+    std::vector<uint8_t> seed_hash(32, 0x2a);
+    std::vector<uint8_t> input(76);
+    std::vector<uint8_t> easy_target(32, 0xFF);
+    easy_target[31] = 0x0F;
+
+    EXPECT_EQ(-1, qm.eventFd());
+    qm.setEventPolling(true);
+    const int fd = qm.eventFd();
+    ASSERT_GE(fd, 0);
+
+    pollfd pfd{fd, POLLIN, 0};
+    EXPECT_EQ(0, poll(&pfd, 1, 0));
+
+    auto sequence_id = qm.start(main_height, seed_height, seed_hash, input, 0, easy_target);
+    ASSERT_EQ(WAIT_SOLUTION, qm.waitForEvent(60000));
+    ASSERT_EQ(1, poll(&pfd, 1, 5000));
+
+    auto events = qm.pollEvents();
+    ASSERT_EQ(1u, events.size());
+    EXPECT_EQ(SOLUTION, events[0].type);
+    EXPECT_EQ(sequence_id, events[0].seq);
+    EXPECT_EQ(qm.solutionNonce(), events[0].nonce);
+
+    // drained: nothing pending and the descriptor is quiet again
+    EXPECT_TRUE(qm.pollEvents().empty());
+    EXPECT_EQ(0, poll(&pfd, 1, 0));
+    EXPECT_EQ(0u, qm.handled.load());
+
+    // back to handleEvent()
+    qm.setEventPolling(false);
+    EXPECT_EQ(-1, qm.eventFd());
+    qm.start(main_height, seed_height, seed_hash, input, 0, easy_target);
+    ASSERT_EQ(WAIT_SOLUTION, qm.waitForEvent(60000));
+    for (int i = 0; i<500 && qm.handled==0; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(1u, qm.handled.load());
+    CHECK_FP_STATE();
+  }
+
+  TEST(QRXMiner, TimerStopsAllThreads)
+  {
+    QRXMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+    std::vector<uint8_t> impossible_target(32, 0);
+
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target, 4);
+    qm.setTimer(300);
+    EXPECT_GT(qm.getSecondsRemaining(), 0);
+
+    auto before = std::chrono::steady_clock::now();
+    EXPECT_EQ(WAIT_DEADLINE, qm.waitForEvent(60000));
+    auto elapsed = std::chrono::steady_clock::now() - before;
+    EXPECT_GE(elapsed, std::chrono::milliseconds(250));
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+    EXPECT_EQ(0, qm.getSecondsRemaining());
+
+    // every worker stops after at most the hash it is currently computing
+    for (int i = 0; i<100 && qm.isRunning(); i++) {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(10ms);
+    }
+    ASSERT_FALSE(qm.isRunning());
+    CHECK_FP_STATE();
+  }
+
+  TEST(QRXMiner, TimerIsPerJob)
+  {
+    QRXMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+    std::vector<uint8_t> impossible_target(32, 0);
+
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target);
+    qm.setTimer(200);
+
+    // the new job must not inherit the timer of the previous one
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target);
+    EXPECT_EQ(WAIT_TIMEOUT, qm.waitForEvent(500));
+    EXPECT_TRUE(qm.isRunning());
+
+    qm.cancel();
+    ASSERT_FALSE(qm.isRunning());
+    CHECK_FP_STATE();
+  }
+
+  TEST(QRXMiner, HashRateLimit)
+  {
+    QRXMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+    std::vector<uint8_t> impossible_target(32, 0);
+
+    EXPECT_THROW(qm.setDutyCycle(0), std::invalid_argument);
+    EXPECT_THROW(qm.setDutyCycle(101), std::invalid_argument);
+
+    qm.setHashRateLimit(20);
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target, 4);
+    qm.waitForAnswer(3);
+    std::cout << std::endl << "hashes/sec: " << qm.hashRate() << std::endl;
+    EXPECT_LE(qm.hashRate(), 30);
+
+    // a thread waiting for its next slot must not delay cancel()
+    qm.setHashRateLimit(1);
+    qm.start(main_height, seed_height, seed_hash, input, 0, impossible_target, 4);
+    qm.waitForEvent(500);
+    auto before = std::chrono::steady_clock::now();
+    qm.cancel();
+    EXPECT_LT(std::chrono::steady_clock::now() - before, std::chrono::milliseconds(500));
+    ASSERT_FALSE(qm.isRunning());
+
+    // a solution is reported before its thread waits for the next slot (4 s here)
+    std::vector<uint8_t> easy_target(32, 0xFF);
+    before = std::chrono::steady_clock::now();
+    qm.start(main_height, seed_height, seed_hash, input, 0, easy_target, 4);
+    ASSERT_TRUE(qm.waitForAnswer(3));
+    EXPECT_TRUE(qm.solutionAvailable());
+    EXPECT_LT(std::chrono::steady_clock::now() - before, std::chrono::seconds(2));
+    qm.cancel();
+    CHECK_FP_STATE();
+  }
+
+  // allocates the dataset, over 2 GB
+  TEST(QRXMiner, DISABLED_FastMode)
+  {
+    QRXMiner qm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+
+    std::vector<uint8_t> target = {
+            0x0F, 0xFF, 0xFF, 0xE1, 0xAC, 0xF3, 0x55, 0x92,
+            0x66, 0xD8, 0x43, 0x89, 0xCE, 0xDE, 0x99, 0x33,
+            0xC6, 0x8F, 0xC5, 0x1E, 0xD0, 0xA6, 0xC7, 0x91,
+            0xF8, 0xF9, 0xE8, 0x9D, 0xB6, 0x23, 0xF0, 0x0F
+    };
+
+    qm.setFastMode(true);
+    qm.start(main_height, seed_height, seed_hash, input, 0, target, 0);
+    qm.waitForAnswer(600);
+    std::cout << std::endl << "fast mode active: " << qm.fastModeActive() << std::endl;
+
+    // full-memory or light fallback, the solution must match a light mode hash
+    ASSERT_TRUE(qm.solutionAvailable());
+    auto light_hash = qrx.hash(main_height, seed_height, seed_hash, qm.solutionInput(), 0);
+    EXPECT_EQ(light_hash, qm.solutionHash());
+    EXPECT_TRUE(PoWHelper::passesTarget(qm.solutionHash(), target));
+
+    qm.cancel();
+    qm.setFastMode(false);
+    EXPECT_FALSE(qm.fastModeActive());
+    EXPECT_FALSE(QRandomX::datasetAvailable());
+    CHECK_FP_STATE();
+  }
+}
@@ -108,4 +108,120 @@ namespace {
     }
     CHECK_FP_STATE();
   }
-}
\ No newline at end of file
+
+  class RetryMiner: public QRXMiner
+  {
+  public:
+    uint8_t handleEvent(MinerEvent event) override
+    {
+      if (event.type == SOLUTION)
+      {
+        attempts++;
+        if (attempts < 4)
+          return 0;
+        delivered = true;
+      }
+      return 1;
+    }
+
+    std::atomic<int> attempts{0};
+    std::atomic_bool delivered{false};
+  };
+
+  class SlowMiner: public QRXMiner
+  {
+  public:
+    uint8_t handleEvent(MinerEvent event) override
+    {
+      if (event.type == SOLUTION)
+      {
+        using namespace std::chrono_literals;
+        in_handler = true;
+        std::this_thread::sleep_for(3s);
+        in_handler = false;
+      }
+      return 1;
+    }
+
+    std::atomic_bool in_handler{false};
+  };
+
+  TEST(QRXMiner, EventRetryBackoff) {
+    RetryMiner qrxm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+
+    std::vector<uint8_t> boundary = {
+            0x9F, 0xFF, 0xFF, 0xE1, 0xAC, 0xF3, 0x55, 0x92,
+            0x66, 0xD8, 0x43, 0x89, 0xCE, 0xDE, 0x99, 0x33,
+            0xC6, 0x8F, 0xC5, 0x1E, 0xD0, 0xA6, 0xC7, 0x91,
+            0xF8, 0xF9, 0xE8, 0x9D, 0xB6, 0x23, 0xF0, 0xFF
+    };
+
+    qrxm.setEventBackoff(1, 8);
+    qrxm.start(main_height, seed_height, seed_hash, input, 0, boundary);
+    qrxm.waitForAnswer(60);
+    ASSERT_TRUE(qrxm.solutionAvailable());
+
+    // 1 + 2 + 4 ms of backoff, well below the old fixed 100 ms per retry
+    for (int i = 0; i<100 && !qrxm.delivered; i++) {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(10ms);
+    }
+    EXPECT_TRUE(qrxm.delivered);
+    EXPECT_EQ(4, qrxm.attempts);
+    CHECK_FP_STATE();
+  }
+
+  TEST(QRXMiner, CancelDuringSlowEvent) {
+    SlowMiner qrxm;
+    ThreadedQRandomX qrx;
+
+    uint64_t main_height = 10;
+    uint64_t seed_height = qrx.getSeedHeight(main_height);
+
+    std::vector<uint8_t> seed_hash {
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+    };
+
+    std::vector<uint8_t> input(76);
+
+    std::vector<uint8_t> boundary = {
+            0x9F, 0xFF, 0xFF, 0xE1, 0xAC, 0xF3, 0x55, 0x92,
+            0x66, 0xD8, 0x43, 0x89, 0xCE, 0xDE, 0x99, 0x33,
+            0xC6, 0x8F, 0xC5, 0x1E, 0xD0, 0xA6, 0xC7, 0x91,
+            0xF8, 0xF9, 0xE8, 0x9D, 0xB6, 0x23, 0xF0, 0xFF
+    };
+
+    qrxm.start(main_height, seed_height, seed_hash, input, 0, boundary);
+    for (int i = 0; i<600 && !qrxm.in_handler; i++) {
+      using namespace std::chrono_literals;
+      std::this_thread::sleep_for(100ms);
+    }
+    ASSERT_TRUE(qrxm.in_handler);
+
+    // a handler that is still running must not hold cancel() back
+    auto before = std::chrono::steady_clock::now();
+    qrxm.cancel();
+    auto elapsed = std::chrono::steady_clock::now() - before;
+
+    EXPECT_TRUE(qrxm.in_handler);
+    EXPECT_LT(elapsed, std::chrono::seconds(1));
+    ASSERT_FALSE(qrxm.isRunning());
+    CHECK_FP_STATE();
+  }
+}
@@ -0,0 +1,50 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <misc/siphash.h>
+#include "gtest/gtest.h"
+
+namespace {
+  std::vector<uint8_t> bytes(const SipHash::Digest &d) {
+    std::vector<uint8_t> out;
+    for (auto word: d) {
+      for (int i = 0; i<8; i++) {
+        out.push_back(static_cast<uint8_t>(word >> (8*i)));
+      }
+    }
+    return out;
+  }
+
+  // vectors_sip128 from the SipHash reference implementation: key 00..0f, message 00..n-1
+  TEST(SipHash, ReferenceVectors) {
+    const SipHash::Key key{0x0706050403020100ull, 0x0f0e0d0c0b0a0908ull};
+    std::vector<uint8_t> message(63);
+    for (size_t i = 0; i<message.size(); i++) {
+      message[i] = static_cast<uint8_t>(i);
+    }
+
+    const std::vector<std::pair<size_t, std::vector<uint8_t>>> vectors{
+            {0,  {0xa3, 0x81, 0x7f, 0x04, 0xba, 0x25, 0xa8, 0xe6, 0x6d, 0xf6, 0x72, 0x14, 0xc7, 0x55, 0x02, 0x93}},
+            {1,  {0xda, 0x87, 0xc1, 0xd8, 0x6b, 0x99, 0xaf, 0x44, 0x34, 0x76, 0x59, 0x11, 0x9b, 0x22, 0xfc, 0x45}},
+            {15, {0x54, 0x93, 0xe9, 0x99, 0x33, 0xb0, 0xa8, 0x11, 0x7e, 0x08, 0xec, 0x0f, 0x97, 0xcf, 0xc3, 0xd9}},
+            {63, {0x51, 0x50, 0xd1, 0x77, 0x2f, 0x50, 0x83, 0x4a, 0x50, 0x3e, 0x06, 0x9a, 0x97, 0x3f, 0xbd, 0x7c}},
+    };
+
+    for (const auto &v: vectors) {
+      EXPECT_EQ(v.second, bytes(SipHash(key).update(message.data(), v.first).digest128())) << v.first;
+
+      // split updates hash the concatenation
+      for (size_t split = 0; split<=v.first; split++) {
+        SipHash h(key);
+        h.update(message.data(), split).update(message.data()+split, v.first-split);
+        EXPECT_EQ(v.second, bytes(h.digest128())) << v.first << " split at " << split;
+      }
+    }
+  }
+
+  TEST(SipHash, Keyed) {
+    const std::vector<uint8_t> input(76, 0x42);
+    EXPECT_NE(SipHash({1, 2}).update(input).digest(), SipHash({1, 3}).update(input).digest());
+    EXPECT_EQ(SipHash::processKey(), SipHash::processKey());
+  }
+}
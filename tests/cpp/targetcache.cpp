@@ -0,0 +1,78 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <random>
+#include <thread>
+#include <pow/targetcache.h>
+#include <pow/powhelper.h>
+#include <misc/bignum.h>
+#include "gtest/gtest.h"
+
+namespace {
+  u256 randomU256(std::mt19937_64 &rng)
+  {
+    // vary the number of significant limbs and bits
+    u256 v(rng(), rng(), rng(), rng());
+    return v >> static_cast<unsigned>(rng()%256);
+  }
+
+  void expectSameDivision(const u256 &a, const u256 &b)
+  {
+    u256 r1;
+    u256 r2;
+    const u256 q1 = u256::divmod(a, b, &r1);
+    const u256 q2 = u256::divmodReciprocal(a, b, &r2);
+    ASSERT_EQ(q1, q2);
+    ASSERT_EQ(r1, r2);
+  }
+
+  TEST(TargetCache, ReciprocalDivision) {
+    std::mt19937_64 rng(3);
+    for (int i = 0; i<200000; i++) {
+      const u256 b = randomU256(rng);
+      if (!b.isZero()) {
+        expectSameDivision(randomU256(rng), b);
+        expectSameDivision(u256::max(), b);
+      }
+    }
+
+    for (const u256 &b : {u256(1), u256(2), u256(3), u256(UINT64_MAX), u256(1) << 63, u256(1) << 64,
+                          u256(0, 0, 1, 0), u256::max(), u256::max() >> 1, u256(0x8000000000000000ULL, 0, 0, 1)}) {
+      expectSameDivision(u256::max(), b);
+      expectSameDivision(u256::max()-b, b);
+      expectSameDivision(b, b);
+    }
+    EXPECT_THROW(u256::divmodReciprocal(u256(1), u256(0)), std::invalid_argument);
+  }
+
+  TEST(TargetCache, GetPut) {
+    TargetCache cache;
+    u256 target;
+
+    EXPECT_FALSE(cache.get(u256(1000), target));
+    cache.put(u256(1000), u256(42));
+    ASSERT_TRUE(cache.get(u256(1000), target));
+    EXPECT_EQ(u256(42), target);
+    EXPECT_FALSE(cache.get(u256(1001), target));
+
+    EXPECT_EQ(u256(), TargetCache::target(u256()));
+    EXPECT_EQ(u256::max()/u256(1000), TargetCache::target(u256(1000)));
+    EXPECT_EQ(u256::max()/u256(1000), TargetCache::target(u256(1000)));
+  }
+
+  TEST(TargetCache, Concurrent) {
+    std::vector<std::thread> threads;
+    for (int t = 0; t<4; t++) {
+      threads.emplace_back([t]() {
+        std::mt19937_64 rng(t);
+        for (int i = 0; i<50000; i++) {
+          // a few hot difficulties and some one-offs competing for slots
+          const u256 difficulty = i%4==0 ? u256(0, 0, rng(), rng()) : u256(1000+rng()%300);
+          ASSERT_EQ(u256::max()/difficulty, TargetCache::target(difficulty));
+        }
+      });
+    }
+    for (auto &thread: threads) {
+      thread.join();
+    }
+  }
+}
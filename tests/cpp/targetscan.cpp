@@ -0,0 +1,92 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <iostream>
+#include <random>
+#include <pow/targetscan.h>
+#include <pow/powhelper.h>
+#include "gtest/gtest.h"
+
+namespace {
+  void expectEquivalent(const std::vector<uint8_t> &hash, const std::vector<uint8_t> &target)
+  {
+    const bool expected = passesTargetScalar(hash.data(), target.data());
+    ASSERT_EQ(expected, passesTargetSIMD(hash.data(), target.data()));
+    ASSERT_EQ(expected, PoWHelper::passesTarget(hash, target));
+  }
+
+  TEST(TargetScan, Implementation) {
+    std::cout << "passesTarget uses " << passesTargetSIMDName() << std::endl;
+  }
+
+  TEST(TargetScan, SingleByteDifferences) {
+    std::mt19937 rng(7);
+    std::vector<uint8_t> target(32);
+    for (auto &b : target) {
+      b = static_cast<uint8_t>(rng());
+    }
+
+    expectEquivalent(target, target);
+    for (int i = 0; i<32; i++) {
+      for (int delta : {-128, -1, 1, 127}) {
+        auto hash = target;
+        hash[i] = static_cast<uint8_t>(hash[i]+delta);
+        expectEquivalent(hash, target);
+      }
+    }
+  }
+
+  TEST(TargetScan, Extremes) {
+    std::vector<uint8_t> zeros(32, 0);
+    std::vector<uint8_t> ones(32, 0xFF);
+    std::vector<uint8_t> signs(32, 0x80);
+
+    for (const auto &a : {zeros, ones, signs}) {
+      for (const auto &b : {zeros, ones, signs}) {
+        expectEquivalent(a, b);
+      }
+    }
+  }
+
+  TEST(TargetScan, Random) {
+    std::mt19937 rng(11);
+    std::vector<uint8_t> hash(32);
+    std::vector<uint8_t> target(32);
+
+    for (int i = 0; i<100000; i++) {
+      for (int j = 0; j<32; j++) {
+        target[j] = static_cast<uint8_t>(rng());
+        hash[j] = static_cast<uint8_t>(rng());
+      }
+      // share a random number of the most significant bytes
+      const int shared = rng() % 33;
+      for (int j = 32-shared; j<32; j++) {
+        hash[j] = target[j];
+      }
+      expectEquivalent(hash, target);
+    }
+  }
+
+  TEST(TargetScan, ScanBatch) {
+    std::mt19937 rng(3);
+    const size_t count = 1000;
+    std::vector<uint8_t> hashes(count*32);
+    for (auto &b : hashes) {
+      b = static_cast<uint8_t>(rng());
+    }
+    std::vector<uint8_t> target(32, 0xFF);
+    target[31] = 0x20;
+
+    std::vector<uint32_t> expected;
+    for (size_t i = 0; i<count; i++) {
+      if (passesTargetScalar(hashes.data()+i*32, target.data())) {
+        expected.push_back(static_cast<uint32_t>(i));
+      }
+    }
+    EXPECT_FALSE(expected.empty());
+
+    auto found = PoWHelper::scanTarget(hashes.data(), hashes.size(), target.data(), target.size());
+    EXPECT_EQ(expected, found);
+
+    EXPECT_THROW(PoWHelper::scanTarget(hashes.data(), 31, target.data(), target.size()), std::invalid_argument);
+  }
+}
@@ -0,0 +1,94 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+#include <misc/tracing.h>
+#include <qrandomx/threadedqrandomx.h>
+#include "gtest/gtest.h"
+#include <atomic>
+#include <thread>
+
+namespace {
+  size_t countOf(const std::string &haystack, const std::string &needle) {
+    size_t count = 0;
+    for (auto pos = haystack.find(needle); pos!=std::string::npos; pos = haystack.find(needle, pos+1)) {
+      count++;
+    }
+    return count;
+  }
+
+  TEST(Tracing, ChromeTraceJson) {
+    ClearTrace();
+    EXPECT_EQ(0, countOf(ChromeTraceJson(), "\"ph\":\"X\""));
+
+    qrx_trace_record("test.span", 2000, 5500, 7);
+    std::thread([]() { qrx_trace_record("test.other_thread", 3000, 4000, 0); }).join();
+    {
+      TraceSpan span("test.scope", 9);
+    }
+
+    const auto json = ChromeTraceJson();
+    EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+    EXPECT_EQ(3, countOf(json, "\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"name\":\"test.span\",\"cat\":\"qrandomx\",\"ph\":\"X\""));
+    EXPECT_NE(std::string::npos, json.find("\"ts\":2.000,\"dur\":3.500,\"args\":{\"id\":7}"));
+    EXPECT_NE(std::string::npos, json.find("test.other_thread"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"id\":9}"));
+
+    ClearTrace();
+    EXPECT_EQ(0, countOf(ChromeTraceJson(), "\"ph\":\"X\""));
+  }
+
+  TEST(Tracing, RingOverwritesOldest) {
+    ClearTrace();
+    for (uint64_t i = 0; i<10000; i++) {
+      qrx_trace_record("test.ring", i*1000, i*1000+1, i);
+    }
+
+    // 4096 slots
+    const auto json = ChromeTraceJson();
+    EXPECT_EQ(4096, countOf(json, "\"name\":\"test.ring\""));
+    EXPECT_EQ(std::string::npos, json.find("\"args\":{\"id\":5903}"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"id\":5904}"));
+    EXPECT_NE(std::string::npos, json.find("\"args\":{\"id\":9999}"));
+    ClearTrace();
+  }
+
+  TEST(Tracing, DumpWhileRecording) {
+    ClearTrace();
+    std::atomic<bool> stop{false};
+    std::thread writer([&stop]() {
+      for (uint64_t i = 0; !stop; i++) {
+        qrx_trace_record("test.concurrent", i, i+1, i);
+      }
+    });
+    for (int i = 0; i<20; i++) {
+      const auto json = ChromeTraceJson();
+      EXPECT_LE(countOf(json, "\"name\":\"test.concurrent\""), 4096);
+      // a torn span would show a duration other than 1 ns
+      EXPECT_EQ(countOf(json, "\"name\":\"test.concurrent\""), countOf(json, "\"dur\":0.001,"));
+    }
+    stop = true;
+    writer.join();
+    ClearTrace();
+  }
+
+  TEST(Tracing, HotPathSpans) {
+    if (!TracingEnabled()) {
+      return;
+    }
+    ClearTrace();
+    {
+      ThreadedQRandomX qrx;
+      const std::vector<uint8_t> seed_hash(32, 0x5a);
+      const std::vector<uint8_t> input(76, 0x01);
+      qrx.hash(10, qrx.getSeedHeight(10), seed_hash, input, 0, 1);
+    }
+
+    const auto json = ChromeTraceJson();
+    for (const auto name: {"threadedqrandomx.hash", "threadedqrandomx.queue", "threadedqrandomx.process",
+                           "rx.wait_rx_mutex", "rx.calculate_hash"}) {
+      EXPECT_NE(std::string::npos, json.find(std::string("\"name\":\"")+name+"\"")) << name;
+    }
+    ClearTrace();
+  }
+}
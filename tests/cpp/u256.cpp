@@ -0,0 +1,122 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+#include <iostream>
+#include <random>
+#include <misc/bignum.h>
+#include <misc/u256.h>
+#include "gtest/gtest.h"
+
+namespace {
+  // compile-time checks
+  static_assert(u256(2)*u256(3)==u256(6), "constexpr multiplication");
+  static_assert(u256::max()/u256(1)==u256::max(), "constexpr division");
+  static_assert((u256(1) << 255 >> 255)==u256(1), "constexpr shifts");
+  static_assert(u256::max()+u256(1)==u256(0), "wraps like unsigned");
+
+  uint256_t toBoost(const u256 &v)
+  {
+    std::vector<uint8_t> bytes(32);
+    v.toBigEndian(bytes.data());
+    return fromByteVector(bytes);
+  }
+
+  u256 fromBoost(const uint256_t &v)
+  {
+    auto bytes = toByteVector(v);
+    return u256::fromBigEndian(bytes.data());
+  }
+
+  // random values with a random number of significant bits
+  u256 randomU256(std::mt19937_64 &rng)
+  {
+    u256 v(rng(), rng(), rng(), rng());
+    return v >> (rng() % 256);
+  }
+
+  TEST(U256, ByteConversions) {
+    std::vector<uint8_t> be(32);
+    for (int i = 0; i<32; i++) {
+      be[i] = static_cast<uint8_t>(i+1);
+    }
+
+    auto v = u256::fromBigEndian(be.data());
+    EXPECT_EQ(0x0102030405060708ULL, v.limb[3]);
+    EXPECT_EQ(0x191a1b1c1d1e1f20ULL, v.limb[0]);
+
+    std::vector<uint8_t> out(32);
+    v.toBigEndian(out.data());
+    EXPECT_EQ(be, out);
+
+    std::vector<uint8_t> le(be.rbegin(), be.rend());
+    EXPECT_EQ(v, u256::fromLittleEndian(le.data()));
+    v.toLittleEndian(out.data());
+    EXPECT_EQ(le, out);
+
+    EXPECT_EQ(toBoost(v), fromByteVector(be));
+  }
+
+  TEST(U256, Bits) {
+    EXPECT_EQ(0, u256().bits());
+    EXPECT_EQ(1, u256(1).bits());
+    EXPECT_EQ(256, u256::max().bits());
+    EXPECT_EQ(129, (u256(1) << 128).bits());
+  }
+
+  TEST(U256, MatchesBoost) {
+    std::mt19937_64 rng(42);
+
+    for (int i = 0; i<20000; i++) {
+      const u256 a = randomU256(rng);
+      const u256 b = randomU256(rng);
+      const uint256_t ba = toBoost(a);
+      const uint256_t bb = toBoost(b);
+
+      ASSERT_EQ(ba+bb, toBoost(a+b));
+      ASSERT_EQ(ba-bb, toBoost(a-b));
+      ASSERT_EQ(ba*bb, toBoost(a*b));
+      ASSERT_EQ(ba < bb, a < b);
+      ASSERT_EQ(ba==bb, a==b);
+
+      const unsigned s = rng() % 256;
+      ASSERT_EQ(ba << s, toBoost(a << s));
+      ASSERT_EQ(ba >> s, toBoost(a >> s));
+
+      if (!b.isZero()) {
+        u256 r;
+        const u256 q = u256::divmod(a, b, &r);
+        ASSERT_EQ(ba/bb, toBoost(q));
+        ASSERT_EQ(ba%bb, toBoost(r));
+      }
+
+      const uint64_t m = rng();
+      uint64_t high = 0;
+      const u256 p = u256::mul(a, m, &high);
+      bigint wide = bigint(ba)*bigint(m);
+      ASSERT_EQ(wide & bigint(uint256_t(-1)), bigint(toBoost(p)));
+      ASSERT_EQ(wide >> 256, bigint(high));
+
+      const uint64_t d = rng() >> (rng()%64);
+      if (d!=0) {
+        bool overflow = false;
+        const u256 q = u256::mulDiv(a, m, d, &overflow);
+        ASSERT_EQ((wide/d) > bigint(uint256_t(-1)), overflow);
+        ASSERT_EQ((wide/d) & bigint(uint256_t(-1)), bigint(toBoost(q)));
+      }
+    }
+  }
+
+  TEST(U256, DivisionEdgeCases) {
+    EXPECT_THROW(u256::divmod(u256(1), u256(0)), std::invalid_argument);
+    EXPECT_THROW(u256::mulDiv(u256(1), 1, 0), std::invalid_argument);
+    EXPECT_EQ(u256(1), u256::max()/u256::max());
+    EXPECT_EQ(u256(0), u256(5)/u256::max());
+    EXPECT_EQ(u256(1) << 192, (u256(1) << 255)/(u256(1) << 63));
+
+    // quotient limbs that need the add-back correction step
+    const u256 a(0x8000000000000000ULL, 0, 0, 0);
+    const u256 b(0, 0, 0x8000000000000000ULL, 1);
+    EXPECT_EQ(toBoost(a)/toBoost(b), toBoost(a/b));
+    EXPECT_EQ(toBoost(u256::max())/toBoost(b), toBoost(u256::max()/b));
+    EXPECT_EQ(fromBoost(toBoost(u256::max())%toBoost(b)), u256::max()%b);
+  }
+}
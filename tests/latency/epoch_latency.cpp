@@ -0,0 +1,255 @@
+// Distributed under the MIT software license, see the accompanying
+// file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+
+// Walks a range of heights crossing several seed epochs (2048 blocks) with a number of
+// hashing threads, optionally interleaving alt-chain hashes, and reports the latency
+// distribution of each setup phase: cache init, dataset init, VM creation, the first hash
+// after a seed change (setup plus waiting for other threads included) and warm hashes.
+//
+//   qrandomx_epoch_latency [--epochs=4] [--step=512] [--threads=1] [--miners=0]
+//                          [--hashes=4] [--alt-every=2] [--json=FILE]
+//
+// --miners>0 hashes in full-memory mode with that many dataset init threads (over 2 GB).
+
+#include <qrandomx/qrandomx.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define EPOCH_BLOCKS 2048
+#define EPOCH_LAG 64
+
+namespace {
+  struct Options {
+    uint32_t epochs = 4;
+    uint32_t step = 512;
+    uint32_t threads = 1;
+    uint32_t miners = 0;
+    uint32_t hashes = 4;
+    uint32_t altEvery = 2;
+    std::string json;
+  };
+
+  class Barrier {
+  public:
+    explicit Barrier(size_t count) : _count(count), _waiting(0), _generation(0) {}
+
+    void wait()
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      const auto generation = _generation;
+      if (++_waiting==_count) {
+        _waiting = 0;
+        _generation++;
+        _released.notify_all();
+      }
+      else {
+        _released.wait(lock, [&] { return generation!=_generation; });
+      }
+    }
+
+  private:
+    std::mutex _mutex;
+    std::condition_variable _released;
+    size_t _count;
+    size_t _waiting;
+    uint64_t _generation;
+  };
+
+  // latencies in milliseconds by phase, in report order
+  class Samples {
+  public:
+    void add(const std::string &phase, double ms)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _samples[phase].push_back(ms);
+    }
+
+    std::map<std::string, std::vector<double>> take()
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      return std::move(_samples);
+    }
+
+  private:
+    std::mutex _mutex;
+    std::map<std::string, std::vector<double>> _samples;
+  };
+
+  std::vector<uint8_t> seedHashFor(uint64_t seedHeight, uint8_t fork)
+  {
+    std::vector<uint8_t> seed(32);
+    uint64_t x = seedHeight*0x9E3779B97F4A7C15ull+fork;
+    for (size_t i = 0; i<seed.size(); i++) {
+      x ^= x >> 29;
+      x *= 0xBF58476D1CE4E5B9ull;
+      seed[i] = static_cast<uint8_t>(x >> 56);
+    }
+    return seed;
+  }
+
+  double percentile(const std::vector<double> &sorted, double p)
+  {
+    // nearest rank
+    const auto rank = static_cast<size_t>(std::max(1.0, std::ceil(p/100.0*sorted.size())));
+    return sorted[std::min(rank, sorted.size())-1];
+  }
+
+  bool parseOption(const char *arg, const char *name, uint32_t &value)
+  {
+    const size_t len = std::strlen(name);
+    if (std::strncmp(arg, name, len)!=0 || arg[len]!='=') {
+      return false;
+    }
+    value = static_cast<uint32_t>(std::strtoul(arg+len+1, nullptr, 10));
+    return true;
+  }
+
+  double ms(uint64_t ns)
+  {
+    return ns/1e6;
+  }
+
+  void worker(const Options &options, uint32_t index, Barrier &barrier, Samples &samples)
+  {
+    using clock = std::chrono::steady_clock;
+    const uint64_t first_height = EPOCH_BLOCKS+EPOCH_LAG+1;
+    const uint64_t steps = uint64_t(options.epochs)*EPOCH_BLOCKS/options.step+1;
+    std::vector<uint8_t> input(76);
+    input[0] = static_cast<uint8_t>(index);
+    uint64_t current_seed_height = UINT64_MAX;
+
+    for (uint64_t step = 0; step<steps; step++) {
+      const uint64_t height = first_height+step*options.step;
+      const uint64_t seed_height = QRandomX::getSeedHeight(height);
+      const auto seed = seedHashFor(seed_height, 0);
+      barrier.wait();
+
+      for (uint32_t h = 0; h<=options.hashes; h++) {
+        input[39] = static_cast<uint8_t>(h);
+        const auto start = clock::now();
+        QRandomX::hash(height, seed_height, seed, input, static_cast<int>(options.miners));
+        const double total = std::chrono::duration<double, std::milli>(clock::now()-start).count();
+        const auto phases = QRandomX::lastPhaseTimes();
+
+        if (phases.cacheInitNs) {
+          samples.add("cache init", ms(phases.cacheInitNs));
+        }
+        if (phases.datasetInitNs) {
+          samples.add("dataset init", ms(phases.datasetInitNs));
+        }
+        if (phases.vmCreateNs) {
+          samples.add("vm create", ms(phases.vmCreateNs));
+        }
+        if (h==0 && seed_height!=current_seed_height) {
+          samples.add(current_seed_height==UINT64_MAX ? "cold start" : "first hash", total);
+          current_seed_height = seed_height;
+        }
+        else {
+          samples.add("warm hash", total);
+        }
+      }
+
+      // a block of a competing chain with the previous epoch's seed, on one thread per step
+      if (options.altEvery && step%options.altEvery==0 && index==step/options.altEvery%options.threads) {
+        const uint64_t alt_seed_height = seed_height>=EPOCH_BLOCKS ? seed_height-EPOCH_BLOCKS : 0;
+        const auto alt_seed = seedHashFor(alt_seed_height, 1);
+        const auto start = clock::now();
+        QRandomX::hash(height, alt_seed_height, alt_seed, input, 0, 1);
+        samples.add("alt hash", std::chrono::duration<double, std::milli>(clock::now()-start).count());
+        const auto phases = QRandomX::lastPhaseTimes();
+        if (phases.cacheInitNs) {
+          samples.add("alt cache init", ms(phases.cacheInitNs));
+        }
+      }
+    }
+    // release the VM of this thread
+    QRandomX().freeVM();
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Options options;
+  for (int i = 1; i<argc; i++) {
+    if (parseOption(argv[i], "--epochs", options.epochs) ||
+        parseOption(argv[i], "--step", options.step) ||
+        parseOption(argv[i], "--threads", options.threads) ||
+        parseOption(argv[i], "--miners", options.miners) ||
+        parseOption(argv[i], "--hashes", options.hashes) ||
+        parseOption(argv[i], "--alt-every", options.altEvery)) {
+      continue;
+    }
+    if (std::strncmp(argv[i], "--json=", 7)==0) {
+      options.json = argv[i]+7;
+      continue;
+    }
+    std::cerr << "usage: " << argv[0] << " [--epochs=N] [--step=BLOCKS] [--threads=N] [--miners=N]"
+              << " [--hashes=N] [--alt-every=STEPS] [--json=FILE]" << std::endl;
+    return 1;
+  }
+  options.step = std::max(1u, options.step);
+  options.threads = std::max(1u, options.threads);
+
+  Barrier barrier(options.threads);
+  Samples samples;
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t<options.threads; t++) {
+    threads.emplace_back(worker, std::cref(options), t, std::ref(barrier), std::ref(samples));
+  }
+  for (auto &thread: threads) {
+    thread.join();
+  }
+
+  const char *order[] = {"cold start", "cache init", "dataset init", "vm create", "first hash",
+                         "warm hash", "alt hash", "alt cache init"};
+  auto results = samples.take();
+
+  std::printf("%-16s %8s %12s %12s %12s\n", "phase", "samples", "p50 ms", "p99 ms", "max ms");
+  std::string json = "{\n  \"context\": {\"epochs\": " + std::to_string(options.epochs) +
+                     ", \"step\": " + std::to_string(options.step) +
+                     ", \"threads\": " + std::to_string(options.threads) +
+                     ", \"miners\": " + std::to_string(options.miners) +
+                     ", \"hashes\": " + std::to_string(options.hashes) +
+                     ", \"alt_every\": " + std::to_string(options.altEvery) + "},\n  \"phases\": [";
+  bool first = true;
+  for (const char *phase: order) {
+    auto &values = results[phase];
+    if (values.empty()) {
+      continue;
+    }
+    std::sort(values.begin(), values.end());
+    const double p50 = percentile(values, 50);
+    const double p99 = percentile(values, 99);
+    std::printf("%-16s %8zu %12.3f %12.3f %12.3f\n", phase, values.size(), p50, p99, values.back());
+
+    char entry[256];
+    std::snprintf(entry, sizeof(entry),
+                  "%s\n    {\"name\": \"%s\", \"samples\": %zu, \"p50_ms\": %.6f, \"p99_ms\": %.6f, \"max_ms\": %.6f}",
+                  first ? "" : ",", phase, values.size(), p50, p99, values.back());
+    json += entry;
+    first = false;
+  }
+  json += "\n  ]\n}\n";
+
+  if (!options.json.empty()) {
+    std::ofstream out(options.json);
+    out << json;
+    if (!out) {
+      std::cerr << "cannot write " << options.json << std::endl;
+      return 1;
+    }
+  }
+  return 0;
+}
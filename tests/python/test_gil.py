@@ -0,0 +1,60 @@
+# Distributed under the MIT software license, see the accompanying
+# file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+from unittest import TestCase
+import os
+import threading
+import time
+
+from pyqrandomx.pyqrandomx import QRXMiner
+from pyqrandomx.pyqrandomx import ThreadedQRandomX
+
+
+class TestGIL(TestCase):
+    def __init__(self, *args, **kwargs):
+        super(TestGIL, self).__init__(*args, **kwargs)
+
+    def _ticks_during(self, call):
+        """Runs call on a worker thread and counts how often this thread ran while it was in flight"""
+        window = []
+
+        def worker():
+            start = time.monotonic()
+            call()
+            window.extend((start, time.monotonic()))
+
+        ticks = []
+        t = threading.Thread(target=worker)
+        t.start()
+        while t.is_alive():
+            ticks.append(time.monotonic())
+            time.sleep(0.001)
+        t.join()
+
+        start, end = window
+        return end - start, sum(1 for tick in ticks if start < tick < end)
+
+    def assertProgress(self, call):
+        duration, ticks = self._ticks_during(call)
+        # holding the GIL would let at most one tick slip in before the native call starts
+        if duration > 0.05:
+            self.assertGreater(ticks, 5)
+
+    def test_wait_releases_gil(self):
+        miner = QRXMiner()
+        duration, ticks = self._ticks_during(lambda: miner.waitForEvent(300))
+        self.assertGreaterEqual(duration, 0.3)
+        self.assertGreater(ticks, 5)
+
+    def test_hash_releases_gil(self):
+        qrx = ThreadedQRandomX()
+        # a seed nobody used yet, so that the call includes the cache initialization
+        self.assertProgress(lambda: qrx.hash(10, 0, os.urandom(32), bytes(76), 0))
+
+    def test_cancel_releases_gil(self):
+        miner = QRXMiner()
+
+        def start_and_cancel():
+            miner.start(10, 0, os.urandom(32), bytes(76), 39, bytes(32), 2)
+            miner.cancel()
+
+        self.assertProgress(start_and_cancel)
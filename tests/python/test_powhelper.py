@@ -3,7 +3,10 @@
 from unittest import TestCase
 from pyqrandomx.pyqrandomx import StringToUInt256, UInt256ToString
 
-from pyqrandomx.pyqrandomx import PoWHelper
+from pyqrandomx.pyqrandomx import PoWHelper, PoWVerifyItem, PoWVerifyItemVector
+from pyqrandomx.pyqrandomx import DifficultySimulator, DifficultySimParams, DifficultySimParamsVector, DifficultySimConfig
+from pyqrandomx.pyqrandomx import ThreadedQRandomX, hash_batch
+from pyqrandomx.pyqrandomx import PRECHECK_OK, PRECHECK_BAD_LENGTH, PRECHECK_BAD_TARGET, PRECHECK_DUPLICATE
 
 
 class TestPowHelper(TestCase):
@@ -95,3 +98,125 @@ class TestPowHelper(TestCase):
         # )
         #
         # self.assertEqual(expected_target, target)
+
+    def test_batch_targets(self):
+        ph = PoWHelper()
+
+        difficulties = [StringToUInt256(str(1000 + i * 997)) for i in range(19)]
+        # little endian: keep the top byte clear so roughly half of them pass
+        hashes = [bytes((i * 31 + j * 7) & 0xFF for j in range(30)) + bytes([i * 7, 0]) for i in range(19)]
+
+        targets = bytearray(32 * len(difficulties))
+        PoWHelper.getTargets(bytes(b for d in difficulties for b in d), targets)
+
+        bitmap = bytearray((len(hashes) + 7) // 8)
+        PoWHelper.passesTargets(b''.join(hashes), memoryview(targets), bitmap)
+
+        for i, (difficulty, h) in enumerate(zip(difficulties, hashes)):
+            target = ph.getTarget(difficulty)
+            self.assertEqual(bytes(target), bytes(targets[i * 32:(i + 1) * 32]))
+            expected = PoWHelper.passesTarget(h, target)
+            self.assertEqual(expected, bool(bitmap[i // 8] & (1 << (i % 8))))
+
+        bitmap2 = bytearray(len(bitmap))
+        PoWHelper.passesDifficulties(b''.join(hashes), bytes(b for d in difficulties for b in d), bitmap2)
+        self.assertEqual(bitmap, bitmap2)
+
+        with self.assertRaises(ValueError):
+            PoWHelper.passesTargets(b''.join(hashes), bytes(targets), bytearray(0))
+
+    def test_verify_inputs(self):
+        ph = PoWHelper()
+
+        main_height = 10
+        seed_height = 0
+        seed_hash = bytes([0x2a, 0x1c, 0x03, 0x5a, 0x8a, 0x5b, 0x4c, 0x38] * 4)
+        target = bytes([0xFF] * 31 + [0x7F])
+
+        items = PoWVerifyItemVector()
+        for i in range(8):
+            items.append(PoWVerifyItem(main_height, seed_height, seed_hash, bytes([i] * 76), target))
+        items.append(PoWVerifyItem(main_height, seed_height, seed_hash, bytes(76), bytes(31)))
+
+        results = ph.verifyInputs(items)
+        self.assertEqual(len(items), len(results))
+        for item, result in list(zip(items, results))[:-1]:
+            self.assertEqual(ph.verifyInput(main_height, seed_height, seed_hash, item.input, target), bool(result))
+        self.assertEqual(0, results[-1])
+
+    def test_precheck_input(self):
+        ph = PoWHelper()
+        ph.setInputLength(76, 76)
+
+        seed_hash = bytes([0x2a] * 32)
+        target = bytes([0x01] + [0x00] * 31)
+
+        self.assertEqual(PRECHECK_OK, ph.precheckInput(seed_hash, bytes(76), target))
+        self.assertEqual(PRECHECK_BAD_LENGTH, ph.precheckInput(seed_hash, bytes(75), target))
+        self.assertEqual(PRECHECK_BAD_TARGET, ph.precheckInput(seed_hash, bytes(76), bytes(32)))
+
+        self.assertFalse(ph.verifyInput(10, 0, seed_hash, bytes(76), target))
+        self.assertEqual(PRECHECK_DUPLICATE, ph.precheckInput(seed_hash, bytes(76), target))
+
+    def test_hash_cache(self):
+        ph = PoWHelper()
+        ph.setHashCacheSize(1 << 20)
+
+        seed_hash = bytes([0x2a] * 32)
+        target = bytes([0xFF] * 32)
+
+        self.assertTrue(ph.verifyInput(10, 0, seed_hash, bytes(76), target))
+        self.assertTrue(ph.verifyInput(10, 0, seed_hash, bytes(76), target))
+
+        stats = ph.hashCacheStats()
+        self.assertEqual(1, stats.hits)
+        self.assertEqual(1, stats.misses)
+        self.assertEqual(1, stats.entries)
+        self.assertLessEqual(stats.bytes, stats.maxBytes)
+
+    def test_difficulty_simulation(self):
+        config = DifficultySimConfig()
+        config.blocks = 5000
+        config.hashrate = 100
+
+        params = DifficultySimParamsVector()
+        for kp in (20, 100, 400):
+            params.append(DifficultySimParams(kp))
+
+        stats = DifficultySimulator.simulate(params, config)
+        self.assertEqual(3, len(stats))
+        for s in stats:
+            self.assertEqual(5000, s.blocks)
+            self.assertGreater(s.meanBlockTime, 0)
+
+        timestamps = [i * 60 for i in range(100)]
+        stats = DifficultySimulator.replay(params, timestamps, config)
+        self.assertEqual(1000, stats[0].finalDifficulty)
+
+    def test_hash_batch(self):
+        qrx = ThreadedQRandomX()
+
+        main_height = 10
+        seed_height = qrx.getSeedHeight(main_height)
+        seed_hash = bytes([0x3c] * 32)
+        blobs = [bytes((i * 13 + j) & 0xFF for j in range(76)) for i in range(9)]
+
+        outputs = hash_batch(main_height, seed_height, seed_hash, blobs, 4)
+        self.assertEqual(9 * 32, len(outputs))
+        for i, blob in enumerate(blobs):
+            expected = bytes(qrx.hash(main_height, seed_height, seed_hash, blob, 0, 1))
+            self.assertEqual(expected, outputs[i * 32:(i + 1) * 32])
+
+        self.assertEqual(b'', hash_batch(main_height, seed_height, seed_hash, []))
+        with self.assertRaises(ValueError):
+            hash_batch(main_height, seed_height, seed_hash, [bytes(76), bytes(75)])
+
+        try:
+            import numpy
+        except ImportError:
+            return
+        array = numpy.frombuffer(b''.join(blobs), dtype=numpy.uint8).reshape(9, 76)
+        hashes = hash_batch(main_height, seed_height, seed_hash, array)
+        self.assertEqual((9, 32), hashes.shape)
+        self.assertEqual(outputs, hashes.tobytes())
+
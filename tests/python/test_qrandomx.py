@@ -1,8 +1,13 @@
 # Distributed under the MIT software license, see the accompanying
 # file LICENSE or http://www.opensource.org/licenses/mit-license.php.
+import json
 from unittest import TestCase
 
-from pyqrandomx.pyqrandomx import ThreadedQRandomX
+from pyqrandomx.pyqrandomx import ThreadedQRandomX, PrometheusMetrics
+from pyqrandomx.pyqrandomx import TracingEnabled, ChromeTraceJson, ClearTrace
+from pyqrandomx.pyqrandomx import LargePages, ALLOCATION_VM, LARGE_PAGES_OFF, LARGE_PAGES_PREFER
+from pyqrandomx.pyqrandomx import PAGES_UNALLOCATED, PAGES_NORMAL
+from pyqrandomx.pyqrandomx import RandomXFlags, FLAG_JIT, FLAG_LARGE_PAGES
 
 
 class TestQRandomX(TestCase):
@@ -49,3 +54,85 @@ class TestQRandomX(TestCase):
             print("0x{:02x}, ".format(i), sep='', end='')
 
         self.assertEqual(output_expected, output)
+
+    def test_hash_into(self):
+        qrx = ThreadedQRandomX()
+
+        main_height = 10
+        seed_height = qrx.getSeedHeight(main_height)
+        seed_hash = bytes([0x2a] * 32)
+        blob = bytearray(i * 7 & 0xFF for i in range(76))
+
+        expected = bytes(qrx.hash(main_height, seed_height, seed_hash, blob, 0))
+
+        output = bytearray(32)
+        qrx.hashInto(main_height, seed_height, seed_hash, memoryview(blob), output, 0)
+        self.assertEqual(expected, bytes(output))
+
+        # slices of a larger buffer are written in place
+        outputs = bytearray(64)
+        qrx.hashInto(main_height, seed_height, seed_hash, bytes(blob), memoryview(outputs)[32:], 0)
+        self.assertEqual(expected, bytes(outputs[32:]))
+        self.assertEqual(bytes(32), bytes(outputs[:32]))
+
+        with self.assertRaises(ValueError):
+            qrx.hashInto(main_height, seed_height, seed_hash, blob, bytearray(31), 0)
+        with self.assertRaises(BufferError):
+            qrx.hashInto(main_height, seed_height, seed_hash, blob, bytes(32), 0)
+
+    def test_metrics(self):
+        qrx = ThreadedQRandomX()
+        qrx.hash(10, 0, bytes([0x6e] * 32), bytes(76), 0)
+
+        text = PrometheusMetrics()
+        self.assertIn('# TYPE qrandomx_hashes_total counter\n', text)
+        self.assertIn('qrandomx_hash_duration_seconds_count ', text)
+
+    def test_trace(self):
+        ClearTrace()
+        qrx = ThreadedQRandomX()
+        qrx.hash(10, 0, bytes([0x6e] * 32), bytes(76), 0)
+
+        trace = json.loads(ChromeTraceJson())
+        names = set(event['name'] for event in trace['traceEvents'])
+        if TracingEnabled():
+            self.assertIn('threadedqrandomx.hash', names)
+            self.assertIn('rx.calculate_hash', names)
+        else:
+            self.assertEqual(set(), names)
+
+    def test_large_pages(self):
+        LargePages.preallocate(False)
+        self.assertNotEqual(PAGES_UNALLOCATED, LargePages.status().cache)
+
+        LargePages.setPolicy(ALLOCATION_VM, LARGE_PAGES_OFF)
+        try:
+            qrx = ThreadedQRandomX()
+            qrx.hash(10, 0, bytes([0x4c] * 32), bytes(76), 0)
+            self.assertEqual(PAGES_NORMAL, LargePages.status().vm)
+        finally:
+            LargePages.setPolicy(LARGE_PAGES_PREFER)
+
+        with self.assertRaises(ValueError):
+            LargePages.setPolicy(ALLOCATION_VM, 7)
+
+    def test_flags_override(self):
+        info = RandomXFlags.get()
+        self.assertEqual((info.detected | info.forced) & ~info.masked, info.effective)
+
+        seed_hash = bytes([0x3e] * 32)
+        blob = bytes([0x11] * 76)
+        qrx = ThreadedQRandomX()
+        expected = qrx.hash(10, 0, seed_hash, blob, 0)
+
+        RandomXFlags.setOverride(0, FLAG_JIT)
+        try:
+            self.assertEqual(0, RandomXFlags.get().effective & FLAG_JIT)
+            self.assertEqual(expected, qrx.hash(10, 0, seed_hash, blob, 0))
+            self.assertEqual(0, RandomXFlags.get().lastVm & FLAG_JIT)
+        finally:
+            RandomXFlags.resetOverride()
+        self.assertEqual(info.effective, RandomXFlags.get().effective)
+
+        with self.assertRaises(ValueError):
+            RandomXFlags.setOverride(FLAG_LARGE_PAGES, 0)
@@ -1,6 +1,8 @@
 # Distributed under the MIT software license, see the accompanying
 # file LICENSE or http://www.opensource.org/licenses/mit-license.php.
 from unittest import TestCase
+import select
+import threading
 import time
 
 from pyqrandomx import pyqrandomx
@@ -345,3 +347,79 @@ class TestQRXMiner(TestCase):
 
         # This property has been just created in the python custom class when the event is received
         self.assertFalse(qm.timeout_triggered)
+
+    def test_miner_wait_for_event(self):
+        qrx = ThreadedQRandomX()
+
+        main_height = 10
+        seed_height = qrx.getSeedHeight(main_height)
+
+        seed_hash = [
+            0x2a, 0x1c, 0x4a, 0x94, 0x33, 0xf1, 0xde, 0x36,
+            0xf8, 0xb9, 0x9c, 0x7c, 0x5a, 0xce, 0xb7, 0xbd,
+            0x2e, 0xb3, 0x9e, 0x1e, 0xad, 0x64, 0x8e, 0xa5,
+            0x82, 0x27, 0xd3, 0x99, 0xad, 0x84, 0xc7, 0x24
+        ]
+        input_bytes = [0] * 76
+        target = [0] * 32
+
+        qm = QRXMiner()
+        qm.start(mainHeight=main_height,
+                 seedHeight=seed_height,
+                 seedHash=seed_hash,
+                 input=input_bytes,
+                 nonceOffset=0,
+                 target=target,
+                 thread_count=2)
+
+        # The wait must not hold the GIL, other python threads keep running
+        ticks = []
+        stop = threading.Event()
+
+        def ticker():
+            while not stop.is_set():
+                ticks.append(1)
+                time.sleep(0.01)
+
+        t = threading.Thread(target=ticker)
+        t.start()
+        self.assertEqual(pyqrandomx.WAIT_TIMEOUT, qm.waitForEvent(500))
+        stop.set()
+        t.join()
+        self.assertGreater(len(ticks), 10)
+
+        qm.cancel()
+        self.assertEqual(pyqrandomx.WAIT_CANCELLED, qm.waitForEvent(10000))
+
+        qm.start(mainHeight=main_height,
+                 seedHeight=seed_height,
+                 seedHash=seed_hash,
+                 input=input_bytes,
+                 nonceOffset=0,
+                 target=target,
+                 thread_count=2)
+        qm.setTimer(200)
+        self.assertEqual(pyqrandomx.WAIT_DEADLINE, qm.waitForEvent(10000))
+
+    def test_event_polling(self):
+        qm = QRXMiner()
+        qrx = ThreadedQRandomX()
+
+        main_height = 10
+        seed_height = qrx.getSeedHeight(main_height)
+        easy_target = bytes([0xFF] * 31 + [0x0F])
+
+        qm.setEventPolling(True)
+        fd = qm.eventFd()
+        self.assertGreaterEqual(fd, 0)
+
+        seq = qm.start(main_height, seed_height, bytes([0x2a] * 32), bytes(76), 39, easy_target, 1)
+        readable, _, _ = select.select([fd], [], [], 60)
+        self.assertEqual([fd], readable)
+
+        events = qm.pollEvents()
+        self.assertEqual(1, len(events))
+        self.assertEqual(pyqrandomx.SOLUTION, events[0].type)
+        self.assertEqual(seq, events[0].seq)
+        self.assertEqual(0, len(qm.pollEvents()))
+